@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -15,7 +15,22 @@ SOURCES += \
     spriteeditor.cpp \
     spritemodel.cpp \
     startmenu.cpp \
-    playbackwindow.cpp
+    playbackwindow.cpp \
+    undohistory.cpp \
+    projectfile.cpp \
+    thumbnailcache.cpp \
+    framecache.cpp \
+    framescheduler.cpp \
+    spriteexporter.cpp \
+    batchprocessor.cpp \
+    tileset.cpp \
+    canvasviewport.cpp \
+    onionskin.cpp \
+    colorpalette.cpp \
+    diagnostics.cpp \
+    autosave.cpp \
+    framestore.cpp \
+    brushstamp.cpp
 
 HEADERS += \
     pencil.h \
@@ -23,7 +38,25 @@ HEADERS += \
     spriteeditor.h \
     spritemodel.h \
     startmenu.h \
-    playbackwindow.h
+    playbackwindow.h \
+    undohistory.h \
+    projectfile.h \
+    pixelops.h \
+    thumbnailcache.h \
+    framecache.h \
+    framescheduler.h \
+    spriteexporter.h \
+    batchprocessor.h \
+    layer.h \
+    compositor.h \
+    tileset.h \
+    canvasviewport.h \
+    onionskin.h \
+    colorpalette.h \
+    diagnostics.h \
+    autosave.h \
+    framestore.h \
+    brushstamp.h
 
 FORMS += \
     spriteeditor.ui \
@@ -0,0 +1,182 @@
+/**
+ * Implementation of the Autosave class, which periodically saves a copy of the project in the background.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Cheuk Yin Lau
+ */
+
+#include "autosave.h"
+#include "projectfile.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+Autosave::Autosave(SpriteModel *model, const QString &fileName, QObject *parent)
+    : QObject(parent)
+    , model(model)
+    , fileName(fileName)
+{
+    timer.setTimerType(Qt::VeryCoarseTimer);
+    timer.setInterval(DefaultIntervalMs);
+
+    connect(&timer,
+            &QTimer::timeout,
+            this,
+            &Autosave::saveNow);
+    connect(&watcher,
+            &QFutureWatcherBase::finished,
+            this,
+            &Autosave::finishSave);
+    timer.start();
+}
+
+Autosave::~Autosave()
+{
+    watcher.waitForFinished();
+}
+
+void Autosave::setFileName(const QString &newFileName)
+{
+    fileName = newFileName;
+}
+
+QString Autosave::getFileName() const
+{
+    return fileName;
+}
+
+QString Autosave::fileNameFor(const QString &projectFileName)
+{
+    if (!projectFileName.isEmpty())
+    {
+        const QFileInfo info(projectFileName);
+        return info.dir().filePath(info.completeBaseName() + ".autosave.ssp");
+    }
+
+    // Named by when the session started, so editors open at the same time never share a file
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(dataDir);
+    const QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz");
+    return QDir(dataDir).filePath(QString("autosave-%1-%2.ssp").arg(stamp).arg(QCoreApplication::applicationPid()));
+}
+
+void Autosave::stop()
+{
+    timer.stop();
+}
+
+void Autosave::setInterval(int intervalMs)
+{
+    timer.setInterval(intervalMs);
+}
+
+void Autosave::saveNow()
+{
+    if (watcher.isRunning() || model->getFrameCount() == 0)
+    {
+        return;
+    }
+
+    Snapshot snapshot;
+    snapshot.fileName = fileName;
+    snapshot.spriteSize = model->getFrame(0)->getSpriteSize();
+    snapshot.palette = model->isIndexedMode() ? model->getPalette().getColors() : QVector<QRgb>();
+    for (int i = 0; i < model->getFrameCount(); i++)
+    {
+        snapshot.versions.append(model->getFrame(i)->getVersion());
+    }
+
+    if (snapshot.fileName == savedFileName && snapshot.palette == savedPalette && snapshot.versions == savedVersions)
+    {
+        return;     // Nothing changed since the last autosave
+    }
+
+    // Only frames without a record or stored copy are copied, so unchanged frames are never detached by later edits,
+    // and frames repeating an earlier frame are not copied at all
+    snapshot.identical = model->findIdenticalFrames();
+    for (int i = 0; i < model->getFrameCount(); i++)
+    {
+        const Sprite *frame = model->getFrame(i);
+        const bool needed = snapshot.identical[i] == i && !records.contains(snapshot.versions[i]);
+        const StoredFrame stored = needed ? frame->getStoredFrame() : StoredFrame();
+        const bool encode = needed && stored.isNull();
+        snapshot.stored.append(stored);
+        snapshot.layers.append(encode ? frame->getLayers() : QVector<Layer>());
+    }
+    snapshot.records = records;
+
+    watcher.setFuture(QtConcurrent::run(&Autosave::write, snapshot));
+}
+
+Autosave::Result Autosave::write(const Snapshot &snapshot)
+{
+    Result result;
+    result.fileName = snapshot.fileName;
+    result.palette = snapshot.palette;
+    result.versions = snapshot.versions;
+
+    // Frames are encoded one after another, an autosave has no reason to take every core from the editor
+    for (int i = 0; i < snapshot.versions.size(); i++)
+    {
+        const quint64 version = snapshot.versions[i];
+        if (snapshot.identical[i] != i)
+        {
+            continue;
+        }
+        if (!snapshot.layers[i].isEmpty())
+        {
+            result.records.insert(version, ProjectFile::encodeLayers(snapshot.layers[i]));
+        }
+        else if (!snapshot.stored[i].isNull())
+        {
+            result.records.insert(version, snapshot.stored[i].read());
+        }
+        else
+        {
+            result.records.insert(version, snapshot.records.value(version));
+        }
+    }
+
+    // A record that could not be read would leave a hole in the project, so the autosave is abandoned
+    for (const QByteArray &record : std::as_const(result.records))
+    {
+        if (record.isEmpty())
+        {
+            return result;
+        }
+    }
+
+    ProjectFile project(snapshot.fileName);
+    result.ok = project.openForWrite(snapshot.spriteSize, int(snapshot.versions.size()), snapshot.palette);
+    for (int i = 0; result.ok && i < snapshot.versions.size(); i++)
+    {
+        result.ok = snapshot.identical[i] != i ? project.writeDuplicate(snapshot.identical[i])
+                                                : project.writeRecord(result.records.value(snapshot.versions[i]));
+    }
+    result.ok = project.close() && result.ok;
+    return result;
+}
+
+void Autosave::finishSave()
+{
+    const Result result = watcher.result();
+    if (!result.ok)
+    {
+        qWarning() << "Could not autosave to" << result.fileName;
+        emit failed(result.fileName);
+        return;
+    }
+
+    // Records of frames that no longer exist are dropped along with the old table
+    records = result.records;
+    savedFileName = result.fileName;
+    savedPalette = result.palette;
+    savedVersions = result.versions;
+    emit saved(result.fileName);
+}
@@ -0,0 +1,162 @@
+/**
+ * Declaration of the Autosave class, which periodically saves a copy of the project in the background.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Cheuk Yin Lau
+ */
+
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include "spritemodel.h"
+
+/**
+ * The Autosave class saves the frames of a model to a separate project file at a fixed interval,
+ * without blocking the editor. On the GUI thread it only takes a snapshot: shallow copies of the
+ * layers of each frame, which share their pixels with the frames until one of them is edited
+ * again. Frames of an opened project that were never loaded are passed on as their stored
+ * records, without being decoded. Encoding and writing happen on the global thread pool, and the file is written to a
+ * temporary file that replaces the previous autosave only once complete.
+ *
+ * The encoded record of every frame is kept by frame version, so frames that have not changed
+ * since the last autosave are neither copied nor encoded again, and an autosave with no changes
+ * at all is skipped. Frames identical to an earlier frame are written as references to it.
+ */
+class Autosave : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * The time between autosaves unless another interval is set, in milliseconds.
+     */
+    static const int DefaultIntervalMs = 60000;
+
+    /**
+     * @brief Constructs an autosave of a model, which starts saving at the default interval.
+     * @param model The model whose frames are saved.
+     * @param fileName The path the autosave is written to.
+     * @param parent Optional QObject parent.
+     */
+    Autosave(SpriteModel *model, const QString &fileName, QObject *parent = nullptr);
+
+    /**
+     * @brief Waits for an autosave still being written before the autosave goes away.
+     */
+    ~Autosave();
+
+    /**
+     * @brief Changes the path the autosave is written to. The next autosave writes every frame.
+     * @param fileName The new path of the autosave.
+     */
+    void setFileName(const QString &fileName);
+
+    /**
+     * @brief Gets the path the autosave is written to.
+     */
+    QString getFileName() const;
+
+    /**
+     * @brief Gets the path of the autosave of a project, next to it as name.autosave.ssp.
+     * @param projectFileName The path of the project, or an empty string for a project never saved.
+     * @return The autosave path. Projects never saved each get their own file in the application data.
+     */
+    static QString fileNameFor(const QString &projectFileName);
+
+    /**
+     * @brief Stops autosaving. An autosave already being written is still finished.
+     */
+    void stop();
+
+    /**
+     * @brief Sets the time between autosaves.
+     * @param intervalMs The interval in milliseconds.
+     */
+    void setInterval(int intervalMs);
+
+public slots:
+
+    /**
+     * @brief Starts an autosave now if the project changed since the last one. Does nothing
+     * while an autosave is still being written, the next one picks up any changes.
+     */
+    void saveNow();
+
+signals:
+
+    /**
+     * @brief Signals that an autosave was written.
+     * @param fileName The path of the autosave.
+     */
+    void saved(const QString &fileName);
+
+    /**
+     * @brief Signals that an autosave could not be written. The previous autosave is left intact.
+     * @param fileName The path of the autosave.
+     */
+    void failed(const QString &fileName);
+
+private slots:
+
+    // Keeps the records of a finished autosave and reports how it went.
+    void finishSave();
+
+private:
+
+    // The state of the project to save, taken on the GUI thread.
+    struct Snapshot
+    {
+        QString fileName;
+        int spriteSize;
+        QVector<QRgb> palette;
+        QVector<quint64> versions;
+        QVector<int> identical;             // The first frame identical to each frame
+        QVector<QVector<Layer>> layers;     // Empty for frames with a record already or a stored copy
+        QVector<StoredFrame> stored;        // Null for frames with a record already or layers to encode
+        QHash<quint64, QByteArray> records;
+    };
+
+    // What a finished autosave wrote.
+    struct Result
+    {
+        bool ok = false;
+        QString fileName;
+        QVector<QRgb> palette;
+        QVector<quint64> versions;
+        QHash<quint64, QByteArray> records;
+    };
+
+    // Encodes the frames without a record and writes the project, on a worker thread.
+    static Result write(const Snapshot &snapshot);
+
+    // The model whose frames are saved.
+    SpriteModel *model;
+
+    // The path the autosave is written to.
+    QString fileName;
+
+    // Starts an autosave at each interval.
+    QTimer timer;
+
+    // Watches the autosave being written on the thread pool.
+    QFutureWatcher<Result> watcher;
+
+    // The encoded record of each frame in the last autosave, by frame version.
+    QHash<quint64, QByteArray> records;
+
+    // The path, palette and frame versions of the last autosave.
+    QString savedFileName;
+    QVector<QRgb> savedPalette;
+    QVector<quint64> savedVersions;
+};
+
+#endif // AUTOSAVE_H
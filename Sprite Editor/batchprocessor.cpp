@@ -0,0 +1,313 @@
+/**
+ * Implementation of the BatchProcessor class, which runs headless batch jobs over .ssp projects.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Matthew Shaw
+ */
+
+#include "batchprocessor.h"
+#include "compositor.h"
+#include "projectfile.h"
+#include "spriteexporter.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+namespace
+{
+// The subcommand names, matching the order of BatchProcessor::Command.
+const QStringList CommandNames{"scale", "convert", "export", "verify"};
+
+// Gets the path of a file with its extension replaced.
+QString withSuffix(const QString &path, const QString &suffix)
+{
+    const QFileInfo info(path);
+    return QDir(info.path()).filePath(info.completeBaseName() + "." + suffix);
+}
+}
+
+bool BatchProcessor::isCommand(const QString &name)
+{
+    return CommandNames.contains(name);
+}
+
+BatchProcessor::BatchProcessor(const QStringList &arguments)
+    : arguments(arguments)
+{
+
+}
+
+int BatchProcessor::exec()
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Scales, converts, exports or verifies .ssp sprite projects.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "One of scale, convert, export or verify.");
+    parser.addPositionalArgument("paths", "Projects, or directories searched recursively for .ssp files.", "<paths...>");
+
+    QCommandLineOption outputOption(QStringList{"o", "output"},
+                                    "Directory results are written to, mirroring the input directories. "
+                                    "By default results are written next to each input, and scale and "
+                                    "convert replace the input.",
+                                    "dir");
+    QCommandLineOption factorOption(QStringList{"f", "factor"}, "Integer factor to enlarge frames by when scaling.", "n", "2");
+    QCommandLineOption formatOption("format", "Export format: png (sprite sheet), gif or apng.", "format", "png");
+    QCommandLineOption fpsOption("fps", "Playback speed of exported animations, 1 to 120.", "fps", "10");
+    QCommandLineOption jobsOption(QStringList{"j", "jobs"},
+                                  "Number of projects processed at once.",
+                                  "n",
+                                  QString::number(QThread::idealThreadCount()));
+    parser.addOptions({outputOption, factorOption, formatOption, fpsOption, jobsOption});
+    parser.process(arguments);
+
+    QStringList paths = parser.positionalArguments();
+    command = Command(CommandNames.indexOf(paths.takeFirst()));
+    if (paths.isEmpty())
+    {
+        err << "No projects given.\n";
+        return 2;
+    }
+
+    bool valid = true;
+    factor = parser.value(factorOption).toInt(&valid);
+    if (!valid || factor < 1 || factor > 64)
+    {
+        err << "The scale factor must be a whole number from 1 to 64.\n";
+        return 2;
+    }
+
+    fps = parser.value(fpsOption).toInt(&valid);
+    if (!valid || fps < 1 || fps > 120)
+    {
+        err << "The frame rate must be a whole number from 1 to 120.\n";
+        return 2;
+    }
+
+    const int jobCount = parser.value(jobsOption).toInt(&valid);
+    if (!valid || jobCount < 1)
+    {
+        err << "The number of jobs must be at least 1.\n";
+        return 2;
+    }
+
+    QString suffix = "ssp";
+    if (command == Command::Export)
+    {
+        suffix = parser.value(formatOption).toLower();
+        SpriteExporter::Format format;
+        if (!SpriteExporter::formatForFile("export." + suffix, format))
+        {
+            err << "Unknown export format " << suffix << ".\n";
+            return 2;
+        }
+    }
+
+    const QVector<Job> jobs = collectJobs(paths, parser.value(outputOption), suffix);
+    if (jobs.isEmpty())
+    {
+        err << "No .ssp projects found.\n";
+        return 1;
+    }
+
+    // Projects run on a pool of their own, since exporting waits on frame encoders in the global pool
+    QThreadPool filePool;
+    filePool.setMaxThreadCount(jobCount);
+    QFuture<QString> results = QtConcurrent::mapped(&filePool, jobs, [this](const Job &job) {
+        return processFile(job);
+    });
+
+    int failed = 0;
+    for (int i = 0; i < jobs.size(); ++i)
+    {
+        const QString error = results.resultAt(i);
+        if (error.isEmpty())
+        {
+            out << "ok      " << jobs[i].input << "\n";
+        }
+        else
+        {
+            out.flush();
+            err << "FAILED  " << jobs[i].input << ": " << error << "\n";
+            err.flush();
+            failed++;
+        }
+    }
+
+    out << jobs.size() - failed << " of " << jobs.size() << " projects processed successfully.\n";
+    return failed == 0 ? 0 : 1;
+}
+
+QVector<BatchProcessor::Job> BatchProcessor::collectJobs(const QStringList &paths,
+                                                         const QString &outputDir,
+                                                         const QString &suffix) const
+{
+    QVector<Job> jobs;
+    for (const QString &path : paths)
+    {
+        QStringList inputs;
+        QDir root;
+        if (QFileInfo(path).isDir())
+        {
+            root.setPath(path);
+            QDirIterator it(path, {"*.ssp"}, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+            {
+                inputs.append(it.next());
+            }
+            inputs.sort();
+        }
+        else
+        {
+            root.setPath(QFileInfo(path).path());
+            inputs.append(path);    // A missing file is reported as a failure when processed
+        }
+
+        for (const QString &input : inputs)
+        {
+            QString output = withSuffix(input, suffix);
+            if (!outputDir.isEmpty())
+            {
+                output = QDir(outputDir).filePath(root.relativeFilePath(output));
+            }
+            jobs.append({input, output});
+        }
+    }
+    return jobs;
+}
+
+QString BatchProcessor::processFile(const Job &job) const
+{
+    QVector<QVector<Layer>> frames;
+    int spriteSize = 0;
+    QVector<QRgb> palette;
+    QString error = readProject(job.input, frames, spriteSize, palette);
+    if (!error.isEmpty() || command == Command::Verify)
+    {
+        return error;
+    }
+
+    if (!QDir().mkpath(QFileInfo(job.output).path()))
+    {
+        return "could not create the output directory";
+    }
+
+    switch (command)
+    {
+    case Command::Scale:
+        for (QVector<Layer> &layers : frames)
+        {
+            for (Layer &layer : layers)
+            {
+                layer.image = layer.image.scaled(layer.image.size() * factor,
+                                                 Qt::IgnoreAspectRatio,
+                                                 Qt::FastTransformation);
+            }
+        }
+        return writeProject(job.output, frames, spriteSize * factor, palette);
+    case Command::Convert:
+        return writeProject(job.output, frames, spriteSize, palette);
+    case Command::Export:
+    {
+        QVector<QImage> images;
+        for (const QVector<Layer> &layers : frames)
+        {
+            images.append(Compositor::flattened(layers));
+        }
+        return SpriteExporter::exportFile(images, job.output, fps) ? QString() : "could not export " + job.output;
+    }
+    case Command::Verify:
+        break;
+    }
+    return QString();
+}
+
+QString BatchProcessor::readProject(const QString &fileName, QVector<QVector<Layer>> &frames, int &spriteSize,
+                                   QVector<QRgb> &palette)
+{
+    ProjectFile project(fileName);
+    if (!project.openForRead())
+    {
+        return "could not be opened as a project";
+    }
+
+    spriteSize = project.getSpriteSize();
+    palette = project.getPalette();
+    const int frameCount = project.getFrameCount();
+    frames.reserve(frameCount);
+
+    QImage image;
+    QByteArray record;
+    while (true)
+    {
+        QVector<Layer> layers;
+        if (project.isLegacyJson())
+        {
+            if (!project.readFrame(image))
+            {
+                break;
+            }
+            layers.append(Layer{image, "Layer 1"});
+        }
+        else
+        {
+            if (!project.readRecord(record))
+            {
+                break;
+            }
+            layers = ProjectFile::decodeLayers(record);
+            if (layers.isEmpty())
+            {
+                return QString("frame %1 could not be decoded").arg(frames.size());
+            }
+        }
+
+        const QSize size = layers.first().image.size();
+        if (size != QSize(spriteSize, spriteSize))
+        {
+            return QString("frame %1 is %2x%3 in a %4x%4 project")
+                .arg(frames.size())
+                .arg(size.width())
+                .arg(size.height())
+                .arg(spriteSize);
+        }
+        frames.append(layers);
+    }
+    project.close();
+
+    if (frameCount == 0)
+    {
+        return "has no frames";
+    }
+    if (frames.size() != frameCount)
+    {
+        return QString("only %1 of %2 frames could be decoded").arg(frames.size()).arg(frameCount);
+    }
+    return QString();
+}
+
+QString BatchProcessor::writeProject(const QString &fileName, const QVector<QVector<Layer>> &frames, int spriteSize,
+                                    const QVector<QRgb> &palette)
+{
+    // Scaling keeps every pixel its color, so the palette of an indexed project still holds them all
+    ProjectFile project(fileName);
+    if (!project.openForWrite(spriteSize, int(frames.size()), palette))
+    {
+        return "could not open " + fileName + " for writing";
+    }
+
+    for (const QVector<Layer> &layers : frames)
+    {
+        project.writeRecord(ProjectFile::encodeLayers(layers));
+    }
+    return project.close() ? QString() : "could not write " + fileName;
+}
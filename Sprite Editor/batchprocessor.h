@@ -0,0 +1,95 @@
+/**
+ * Declaration of the BatchProcessor class, which runs headless batch jobs over .ssp projects.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Matthew Shaw
+ */
+
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "layer.h"
+
+/**
+ * The BatchProcessor class implements the command line mode of the editor, used by asset
+ * builds to scale, convert, export and verify projects without showing any windows. Projects
+ * are read and written with ProjectFile, the same code the editor uses, but frames stay plain
+ * layers of QImages so no widgets are ever created. Files are processed in parallel, one per thread.
+ *
+ * Usage: <program> (scale|convert|export|verify) [options] <paths...>
+ * where each path is a project or a directory searched recursively for .ssp files.
+ */
+class BatchProcessor
+{
+public:
+
+    /**
+     * @brief Checks whether a command line argument names a batch subcommand.
+     * @param name The first argument passed to the program.
+     * @return True if the program should run headless.
+     */
+    static bool isCommand(const QString &name);
+
+    /**
+     * @brief Constructs a batch run from the program's arguments.
+     * @param arguments All command line arguments, including the program name.
+     */
+    explicit BatchProcessor(const QStringList &arguments);
+
+    /**
+     * @brief Processes every project named on the command line, printing one line per file.
+     * @return 0 if every file succeeded, 1 if any failed and 2 for invalid arguments.
+     */
+    int exec();
+
+private:
+
+    // The subcommands, in the order of their names in isCommand.
+    enum class Command
+    {
+        Scale,
+        Convert,
+        Export,
+        Verify
+    };
+
+    // A project to process and where its result goes.
+    struct Job
+    {
+        QString input;
+        QString output;
+    };
+
+    // Finds the projects under the given paths and works out their output files.
+    QVector<Job> collectJobs(const QStringList &paths, const QString &outputDir, const QString &suffix) const;
+
+    // Runs the command on one project. Returns an empty string on success, otherwise the reason it failed.
+    QString processFile(const Job &job) const;
+
+    // Reads and decodes the layers of every frame of a project, and its palette if it was saved in indexed mode.
+    static QString readProject(const QString &fileName, QVector<QVector<Layer>> &frames, int &spriteSize,
+                               QVector<QRgb> &palette);
+
+    // Writes the layers of every frame as a binary project, with a palette unless it is empty.
+    static QString writeProject(const QString &fileName, const QVector<QVector<Layer>> &frames, int spriteSize,
+                                const QVector<QRgb> &palette);
+
+    // The command line, including the program name.
+    QStringList arguments;
+
+    // The subcommand being run.
+    Command command = Command::Verify;
+
+    // The integer factor frames are enlarged by when scaling.
+    int factor = 2;
+
+    // The playback speed of exported animations.
+    int fps = 10;
+};
+
+#endif // BATCHPROCESSOR_H
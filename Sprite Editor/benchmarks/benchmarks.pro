@@ -0,0 +1,6 @@
+TEMPLATE = subdirs
+
+# Each suite is its own test executable, run them all with "make check"
+SUBDIRS += \
+    canvasformat \
+    editor
@@ -0,0 +1,21 @@
+QT       += core gui testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = canvasbenchmarks
+
+# The benchmarks exercise the editor's pixel code directly
+INCLUDEPATH += ../..
+
+SOURCES += \
+    tst_canvasformat.cpp \
+    ../../canvasviewport.cpp \
+    ../../tileset.cpp
+
+HEADERS += \
+    ../../canvasviewport.h \
+    ../../compositor.h \
+    ../../layer.h \
+    ../../pixelops.h \
+    ../../tileset.h
@@ -0,0 +1,207 @@
+/**
+ * Benchmarks comparing ARGB32 and premultiplied ARGB32 as the canvas format.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Pierce Jones
+ */
+
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QtTest>
+#include "canvasviewport.h"
+#include "compositor.h"
+#include "pixelops.h"
+
+/**
+ * Every benchmark runs once per canvas format and size so the rows can be compared directly.
+ * The viewport rows need a GUI application for their pixmaps, so pass "-platform offscreen"
+ * when no display is available.
+ * Run with, for example, "canvasbenchmarks -tickcounter" for cycle counts.
+ */
+class CanvasFormatBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    // Scales the whole canvas into a widget-sized image in one QPainter call. This is only a comparison of
+    // how fast QPainter reads each format, the editor paints through CanvasViewport instead.
+    void paintScaled_data();
+    void paintScaled();
+
+    // Paints a widget-sized view of the canvas through CanvasViewport, as Sprite::paintEvent does, with the
+    // scaled blocks either already cached or dropped before every paint.
+    void viewportPaint_data();
+    void viewportPaint();
+
+    // Fills the whole canvas with a translucent color through QPainter.
+    void painterFill_data();
+    void painterFill();
+
+    // Fills the whole canvas with a translucent color through PixelOps, as the pencil does.
+    void pixelFill_data();
+    void pixelFill();
+
+    // Composites a single translucent layer, as Sprite::getImage does.
+    void flatten_data();
+    void flatten();
+
+private:
+
+    // Adds a row for each canvas format at each canvas size.
+    static void addFormats();
+
+    // Makes a canvas of random translucent pixels.
+    static QImage noise(int size, QImage::Format format);
+};
+
+void CanvasFormatBenchmark::addFormats()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<int>("size");
+
+    for (int size : {1024, 4096})
+    {
+        QTest::addRow("argb32 %d", size) << int(QImage::Format_ARGB32) << size;
+        QTest::addRow("premultiplied %d", size) << int(QImage::Format_ARGB32_Premultiplied) << size;
+    }
+}
+
+QImage CanvasFormatBenchmark::noise(int size, QImage::Format format)
+{
+    QImage image(size, size, QImage::Format_ARGB32);
+    QRandomGenerator random(size);
+    for (int y = 0; y < size; ++y)
+    {
+        QRgb *row = PixelOps::row(image, y);
+        for (int x = 0; x < size; ++x)
+        {
+            row[x] = random.generate();
+        }
+    }
+    return image.convertToFormat(format);
+}
+
+void CanvasFormatBenchmark::paintScaled_data()
+{
+    addFormats();
+}
+
+void CanvasFormatBenchmark::paintScaled()
+{
+    QFETCH(int, format);
+    QFETCH(int, size);
+
+    const QImage canvas = noise(size, QImage::Format(format));
+    QImage backing(620, 620, QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK
+    {
+        QPainter painter(&backing);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(backing.rect(), canvas);
+    }
+}
+
+void CanvasFormatBenchmark::viewportPaint_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("cached");
+
+    for (int size : {1024, 4096})
+    {
+        QTest::addRow("cached %d", size) << size << true;
+        QTest::addRow("uncached %d", size) << size << false;
+    }
+}
+
+void CanvasFormatBenchmark::viewportPaint()
+{
+    QFETCH(int, size);
+    QFETCH(bool, cached);
+
+    // The viewport only draws the premultiplied composite, so there is no format to compare
+    const QImage canvas = noise(size, QImage::Format_ARGB32_Premultiplied);
+    QImage widget(620, 620, QImage::Format_ARGB32_Premultiplied);
+    CanvasViewport viewport;
+    viewport.setCanvasSize(size);
+    viewport.setWidgetSize(widget.size());
+    {
+        QPainter painter(&widget);
+        viewport.paint(painter, widget.rect(), canvas);
+    }
+
+    QBENCHMARK
+    {
+        if (!cached)
+        {
+            viewport.clearCache();
+        }
+        QPainter painter(&widget);
+        viewport.paint(painter, widget.rect(), canvas);
+    }
+}
+
+void CanvasFormatBenchmark::painterFill_data()
+{
+    addFormats();
+}
+
+void CanvasFormatBenchmark::painterFill()
+{
+    QFETCH(int, format);
+    QFETCH(int, size);
+
+    QImage canvas = noise(size, QImage::Format(format));
+
+    QBENCHMARK
+    {
+        QPainter painter(&canvas);
+        painter.fillRect(canvas.rect(), QColor(255, 0, 0, 128));
+    }
+}
+
+void CanvasFormatBenchmark::pixelFill_data()
+{
+    addFormats();
+}
+
+void CanvasFormatBenchmark::pixelFill()
+{
+    QFETCH(int, format);
+    QFETCH(int, size);
+
+    QImage canvas = noise(size, QImage::Format(format));
+    const QRgb color = PixelOps::pixelFor(canvas, qRgba(255, 0, 0, 128));
+
+    QBENCHMARK
+    {
+        PixelOps::fillRect(canvas, canvas.rect(), color);
+    }
+}
+
+void CanvasFormatBenchmark::flatten_data()
+{
+    addFormats();
+}
+
+void CanvasFormatBenchmark::flatten()
+{
+    QFETCH(int, format);
+    QFETCH(int, size);
+
+    Layer layer;
+    layer.image = noise(size, QImage::Format(format));
+    const QVector<Layer> layers{layer};
+    QImage composite(size, size, QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK
+    {
+        Compositor::flatten(composite, layers, composite.rect());
+    }
+}
+
+QTEST_MAIN(CanvasFormatBenchmark)
+
+#include "tst_canvasformat.moc"
@@ -0,0 +1,45 @@
+QT       += core gui widgets concurrent testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = editorbenchmarks
+
+# The benchmarks drive the editor's model and widgets without the main window
+INCLUDEPATH += ../..
+
+SOURCES += \
+    tst_editor.cpp \
+    ../../pencil.cpp \
+    ../../sprite.cpp \
+    ../../spritemodel.cpp \
+    ../../undohistory.cpp \
+    ../../projectfile.cpp \
+    ../../thumbnailcache.cpp \
+    ../../framescheduler.cpp \
+    ../../spriteexporter.cpp \
+    ../../tileset.cpp \
+    ../../canvasviewport.cpp \
+    ../../colorpalette.cpp \
+    ../../diagnostics.cpp \
+    ../../framestore.cpp \
+    ../../brushstamp.cpp
+
+HEADERS += \
+    ../../pencil.h \
+    ../../sprite.h \
+    ../../spritemodel.h \
+    ../../undohistory.h \
+    ../../projectfile.h \
+    ../../pixelops.h \
+    ../../thumbnailcache.h \
+    ../../framescheduler.h \
+    ../../spriteexporter.h \
+    ../../layer.h \
+    ../../compositor.h \
+    ../../tileset.h \
+    ../../canvasviewport.h \
+    ../../colorpalette.h \
+    ../../diagnostics.h \
+    ../../framestore.h \
+    ../../brushstamp.h
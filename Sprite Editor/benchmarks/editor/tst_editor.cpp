@@ -0,0 +1,553 @@
+/**
+ * Benchmarks of the editor's projects, tools, undo history, frame icons and playback.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer John Gibb
+ */
+
+#include <QApplication>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QImageReader>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <algorithm>
+#include "framescheduler.h"
+#include "pencil.h"
+#include "spriteexporter.h"
+#include "spritemodel.h"
+#include "thumbnailcache.h"
+
+/**
+ * Every fixture is generated from a fixed seed, so each row does the same work on every run
+ * and every version of the editor. Results are written as CSV unless another format is asked
+ * for, one line per row, so the output of two versions can be diffed directly:
+ *
+ *     editorbenchmarks > before.csv
+ *     editorbenchmarks > after.csv
+ *     diff before.csv after.csv
+ *
+ * Frames are widgets, so on a machine without a display run with QT_QPA_PLATFORM=offscreen.
+ */
+class EditorBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    // Saves a project, as SpriteModel::saveProject does from the File menu.
+    void saveProject_data();
+    void saveProject();
+
+    // Saves a project whose frames are each held for four frames, which are written once each.
+    void saveHeldProject_data();
+    void saveHeldProject();
+
+    // Opens a saved project into a new model.
+    void loadProject_data();
+    void loadProject();
+
+    // Stamps a square brush once per point of a stroke with the legacy Pencil::draw, as a baseline for pencilStroke.
+    void pencilDraw_data();
+    void pencilDraw();
+
+    // Draws the same stroke with Pencil::stroke, as the canvas does.
+    void pencilStroke_data();
+    void pencilStroke();
+
+    // Draws the same stroke with each brush shape and mirror mode.
+    void pencilStamp_data();
+    void pencilStamp();
+
+    // Undoes and redoes a recolor of most of the frame.
+    void undoRedo_data();
+    void undoRedo();
+
+    // Regenerates the icon of every frame after each one changed, as updateFrameIcons requests.
+    void frameIcons_data();
+    void frameIcons();
+
+    // Writes an animated GIF, then reads it back to check every pixel survived the encoder.
+    void exportGif_data();
+    void exportGif();
+
+    // Plays an animation for a second and measures how far frames land from when they were due.
+    void playbackJitter_data();
+    void playbackJitter();
+
+    // Plays an animation for a second and measures the rate frames were actually shown at.
+    void playbackRate_data();
+    void playbackRate();
+
+private:
+
+    // Timestamps of the frames shown by a second of playback, in milliseconds.
+    static QVector<double> play(double fps);
+
+    // Adds a row for each combination of frame size and frame count.
+    static void addProjects();
+
+    // Adds a row for each brush size on each canvas size.
+    static void addBrushes();
+
+    // Adds a row for each playback rate.
+    static void addRates();
+
+    // Makes a model of the given number of painted frames, each repeated the given number of times.
+    static SpriteModel *makeProject(int size, int frameCount, int hold = 1);
+
+    // Deletes the frames of a model, which it does not own.
+    static void releaseProject(SpriteModel *model);
+
+    // Paints a frame with flat colored rectangles on a solid background, like pixel art.
+    static void paintFixture(Sprite *sprite, quint32 seed);
+
+    // Makes a random walk across the canvas, as a quick freehand stroke would be.
+    static QVector<QPoint> strokePath(int size);
+
+    // The solid background paintFixture leaves behind the rectangles.
+    static const QRgb Background = 0xff203040;
+};
+
+void EditorBenchmark::addProjects()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("frameCount");
+
+    for (int size : {64, 256, 1024})
+    {
+        for (int frameCount : {4, 32})
+        {
+            QTest::addRow("%dpx %d frames", size, frameCount) << size << frameCount;
+        }
+    }
+}
+
+void EditorBenchmark::addBrushes()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("brush");
+
+    for (int size : {256, 1024})
+    {
+        for (int brush : {1, 8, 32})
+        {
+            QTest::addRow("%dpx brush %d", size, brush) << size << brush;
+        }
+    }
+}
+
+void EditorBenchmark::addRates()
+{
+    QTest::addColumn<double>("fps");
+
+    for (int fps : {12, 24, 60})
+    {
+        QTest::addRow("%d fps", fps) << double(fps);
+    }
+}
+
+SpriteModel *EditorBenchmark::makeProject(int size, int frameCount, int hold)
+{
+    SpriteModel *model = new SpriteModel(size);
+    for (int i = 1; i < frameCount * hold; i++)
+    {
+        model->addFrame(i);
+    }
+    for (int i = 0; i < frameCount * hold; i++)
+    {
+        paintFixture(model->getFrame(i), quint32(i / hold + 1));
+    }
+    return model;
+}
+
+void EditorBenchmark::releaseProject(SpriteModel *model)
+{
+    for (int i = 0; i < model->getFrameCount(); i++)
+    {
+        delete model->getFrame(i);
+    }
+    delete model;
+}
+
+void EditorBenchmark::paintFixture(Sprite *sprite, quint32 seed)
+{
+    const int size = sprite->getSpriteSize();
+    QRandomGenerator random(seed);
+    sprite->fill(Background);
+    for (int i = 0; i < 64; i++)
+    {
+        const int width = random.bounded(1, qMax(2, size / 8));
+        const int height = random.bounded(1, qMax(2, size / 8));
+        const QRect rect(random.bounded(size), random.bounded(size), width, height);
+        sprite->fillRect(rect, qRgb(random.bounded(16) * 16, random.bounded(16) * 16, random.bounded(16) * 16));
+    }
+}
+
+QVector<QPoint> EditorBenchmark::strokePath(int size)
+{
+    QRandomGenerator random(quint32(size));
+    QVector<QPoint> points;
+    QPoint point(size / 2, size / 2);
+    for (int i = 0; i < 512; i++)
+    {
+        point += QPoint(random.bounded(-8, 9), random.bounded(-8, 9));
+        point.setX(qBound(0, point.x(), size - 1));
+        point.setY(qBound(0, point.y(), size - 1));
+        points.append(point);
+    }
+    return points;
+}
+
+void EditorBenchmark::saveProject_data()
+{
+    addProjects();
+}
+
+void EditorBenchmark::saveProject()
+{
+    QFETCH(int, size);
+    QFETCH(int, frameCount);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("benchmark.ssp");
+    SpriteModel *model = makeProject(size, frameCount);
+
+    QBENCHMARK
+    {
+        model->saveProject(fileName);
+    }
+
+    releaseProject(model);
+}
+
+void EditorBenchmark::saveHeldProject_data()
+{
+    addProjects();
+}
+
+void EditorBenchmark::saveHeldProject()
+{
+    QFETCH(int, size);
+    QFETCH(int, frameCount);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("benchmark.ssp");
+    SpriteModel *model = makeProject(size, frameCount, 4);
+
+    QBENCHMARK
+    {
+        model->saveProject(fileName);
+    }
+
+    releaseProject(model);
+}
+
+void EditorBenchmark::loadProject_data()
+{
+    addProjects();
+}
+
+void EditorBenchmark::loadProject()
+{
+    QFETCH(int, size);
+    QFETCH(int, frameCount);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("benchmark.ssp");
+    SpriteModel *saved = makeProject(size, frameCount);
+    saved->saveProject(fileName);
+    releaseProject(saved);
+
+    // Freeing the loaded frames is timed too, the same as closing the project would be
+    QBENCHMARK
+    {
+        SpriteModel *model = new SpriteModel();
+        model->loadProject(fileName);
+        QCOMPARE(model->getFrameCount(), frameCount);
+        releaseProject(model);
+    }
+}
+
+void EditorBenchmark::pencilDraw_data()
+{
+    addBrushes();
+}
+
+void EditorBenchmark::pencilDraw()
+{
+    QFETCH(int, size);
+    QFETCH(int, brush);
+
+    QImage canvas(size, size, QImage::Format_ARGB32_Premultiplied);
+    canvas.fill(Qt::transparent);
+    Pencil pencil(brush, QColor(255, 0, 0, 128));
+    const QVector<QPoint> points = strokePath(size);
+
+    QBENCHMARK
+    {
+        for (const QPoint &point : points)
+        {
+            pencil.draw(point.x(), point.y(), canvas, size);
+        }
+    }
+}
+
+void EditorBenchmark::pencilStroke_data()
+{
+    addBrushes();
+}
+
+void EditorBenchmark::pencilStroke()
+{
+    QFETCH(int, size);
+    QFETCH(int, brush);
+
+    QImage canvas(size, size, QImage::Format_ARGB32_Premultiplied);
+    canvas.fill(Qt::transparent);
+    Pencil pencil(brush, QColor(255, 0, 0, 128));
+    const QVector<QPoint> points = strokePath(size);
+
+    QBENCHMARK
+    {
+        pencil.stroke(points, canvas);
+    }
+}
+
+void EditorBenchmark::pencilStamp_data()
+{
+    QTest::addColumn<int>("shape");
+    QTest::addColumn<int>("mirror");
+
+    const QList<QPair<const char *, BrushShape>> shapes{
+        {"square", BrushShape::Square}, {"circle", BrushShape::Circle}, {"dither", BrushShape::Dither}};
+    const QList<QPair<const char *, MirrorMode>> mirrors{
+        {"no mirror", MirrorMode::None}, {"horizontal", MirrorMode::Horizontal}, {"radial", MirrorMode::Radial}};
+    for (const auto &shape : shapes)
+    {
+        for (const auto &mirror : mirrors)
+        {
+            QTest::addRow("%s %s", shape.first, mirror.first) << int(shape.second) << int(mirror.second);
+        }
+    }
+}
+
+void EditorBenchmark::pencilStamp()
+{
+    QFETCH(int, shape);
+    QFETCH(int, mirror);
+
+    QImage canvas(256, 256, QImage::Format_ARGB32_Premultiplied);
+    canvas.fill(Qt::transparent);
+    Pencil pencil(8, QColor(255, 0, 0, 128));
+    pencil.setBrushShape(BrushShape(shape));
+    pencil.setMirrorMode(MirrorMode(mirror));
+    const QVector<QPoint> points = strokePath(256);
+
+    QBENCHMARK
+    {
+        pencil.stroke(points, canvas);
+    }
+}
+
+void EditorBenchmark::undoRedo_data()
+{
+    QTest::addColumn<int>("size");
+
+    for (int size : {64, 256, 1024})
+    {
+        QTest::addRow("%dpx", size) << size;
+    }
+}
+
+void EditorBenchmark::undoRedo()
+{
+    QFETCH(int, size);
+
+    Sprite sprite(size);
+    paintFixture(&sprite, 1);
+    QVERIFY(!sprite.replaceColor(Background, qRgb(255, 255, 255)).isEmpty());
+
+    // The pair leaves the frame as it started, so every iteration does the same work
+    QBENCHMARK
+    {
+        sprite.undoPaint();
+        sprite.redoPaint();
+    }
+}
+
+void EditorBenchmark::frameIcons_data()
+{
+    addProjects();
+}
+
+void EditorBenchmark::frameIcons()
+{
+    QFETCH(int, size);
+    QFETCH(int, frameCount);
+
+    SpriteModel *model = makeProject(size, frameCount);
+    ThumbnailCache cache(model, QSize(75, 75));
+    QSignalSpy ready(&cache, &ThumbnailCache::thumbnailReady);
+    int round = 0;
+
+    // The pass is started directly, skipping the timer that merges requests while the user draws
+    QBENCHMARK
+    {
+        round++;
+        for (int i = 0; i < frameCount; i++)
+        {
+            model->getFrame(i)->fillRect(QRect(0, 0, 1, 1), round % 2 ? qRgb(255, 0, 0) : qRgb(0, 0, 255));
+        }
+
+        ready.clear();
+        QVERIFY(QMetaObject::invokeMethod(&cache, "regenerate"));
+        while (ready.count() < frameCount)
+        {
+            QVERIFY(ready.wait(5000));
+        }
+    }
+
+    releaseProject(model);
+}
+
+void EditorBenchmark::exportGif_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("colors");
+
+    // Noise in many colors fills the LZW dictionary often, crossing every code width
+    for (int size : {16, 64, 256})
+    {
+        for (int colors : {4, 255})
+        {
+            QTest::addRow("%dpx %d colors", size, colors) << size << colors;
+        }
+    }
+}
+
+void EditorBenchmark::exportGif()
+{
+    QFETCH(int, size);
+    QFETCH(int, colors);
+
+    QRandomGenerator random(quint32(size * 1000 + colors));
+    QVector<QRgb> palette;
+    for (int i = 0; i < colors; i++)
+    {
+        palette.append(0xFF000000 | (random.generate() & 0xFFFFFF));
+    }
+    QVector<QImage> frames;
+    for (int i = 0; i < 4; i++)
+    {
+        QImage frame(size, size, QImage::Format_ARGB32);
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                frame.setPixel(x, y, palette[random.bounded(colors)]);
+            }
+        }
+        frames.append(frame);
+    }
+
+    QByteArray gif;
+    QBENCHMARK
+    {
+        gif.clear();
+        QBuffer buffer(&gif);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(SpriteExporter::writeGif(frames, buffer, 12));
+    }
+
+    // Fewer than 256 colors are kept exactly, so every frame must read back unchanged
+    QBuffer buffer(&gif);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, "gif");
+    for (const QImage &frame : std::as_const(frames))
+    {
+        const QImage decoded = reader.read();
+        QVERIFY2(!decoded.isNull(), qPrintable(reader.errorString()));
+        QCOMPARE(decoded.convertToFormat(QImage::Format_ARGB32), frame);
+    }
+}
+
+QVector<double> EditorBenchmark::play(double fps)
+{
+    QElapsedTimer clock;
+    QVector<double> shownAt;
+    FrameScheduler scheduler;
+    scheduler.setFrameCount(8);
+    scheduler.setFps(fps);
+    connect(&scheduler, &FrameScheduler::frameChanged, &scheduler, [&]() {
+        shownAt.append(clock.nsecsElapsed() / 1e6);
+    });
+
+    clock.start();
+    scheduler.start();
+    QTest::qWait(1000);
+    scheduler.stop();
+    return shownAt;
+}
+
+void EditorBenchmark::playbackJitter_data()
+{
+    addRates();
+}
+
+void EditorBenchmark::playbackJitter()
+{
+    QFETCH(double, fps);
+
+    const QVector<double> shownAt = play(fps);
+    QVERIFY(shownAt.size() > 1);
+
+    // The mean distance of each frame from where a perfect clock would have shown it
+    double deviation = 0;
+    for (int i = 1; i < shownAt.size(); i++)
+    {
+        deviation += qAbs(shownAt[i] - (shownAt.first() + i * 1000.0 / fps));
+    }
+    QTest::setBenchmarkResult(deviation / (shownAt.size() - 1), QTest::WalltimeMilliseconds);
+}
+
+void EditorBenchmark::playbackRate_data()
+{
+    addRates();
+}
+
+void EditorBenchmark::playbackRate()
+{
+    QFETCH(double, fps);
+
+    const QVector<double> shownAt = play(fps);
+    QVERIFY(shownAt.size() > 1);
+    QTest::setBenchmarkResult((shownAt.size() - 1) * 1000.0 / (shownAt.last() - shownAt.first()),
+                              QTest::FramesPerSecond);
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    EditorBenchmark benchmark;
+
+    // CSV unless a format or output file is chosen on the command line
+    QStringList arguments = app.arguments();
+    static const QStringList formats{"-o", "-txt", "-csv", "-xml", "-lightxml", "-junitxml", "-teamcity", "-tap"};
+    const bool formatChosen = std::any_of(arguments.cbegin(), arguments.cend(), [](const QString &argument) {
+        return formats.contains(argument);
+    });
+    if (!formatChosen)
+    {
+        arguments.append("-csv");
+    }
+    return QTest::qExec(&benchmark, arguments);
+}
+
+#include "tst_editor.moc"
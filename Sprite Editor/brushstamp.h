@@ -0,0 +1,98 @@
+/**
+ * Declaration of the BrushStamp class, the precomputed shape the pencil leaves at each point of a stroke.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Matthew Shaw
+ */
+
+#ifndef BRUSHSTAMP_H
+#define BRUSHSTAMP_H
+
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <vector>
+
+/**
+ * The BrushStamp class holds the shape of a brush as a mask of one byte per pixel, set to 1
+ * where the brush paints. Shapes are worked out once when the brush changes, so stamping
+ * the brush along a stroke only copies rows of the mask. Patterned stamps keep a second mask
+ * shifted by one pixel, so the pattern stays lined up with the canvas wherever it is stamped.
+ */
+class BrushStamp
+{
+public:
+
+    /**
+     * @brief Constructs an empty stamp, which paints nothing.
+     */
+    BrushStamp() = default;
+
+    /**
+     * @brief Makes a solid square stamp.
+     * @param size The side length of the square.
+     */
+    static BrushStamp square(int size);
+
+    /**
+     * @brief Makes a solid round stamp.
+     * @param size The diameter of the circle.
+     */
+    static BrushStamp circle(int size);
+
+    /**
+     * @brief Makes a round stamp that paints every other pixel in a checkerboard.
+     * @param size The diameter of the circle.
+     */
+    static BrushStamp dither(int size);
+
+    /**
+     * @brief Makes a stamp from the pixels of an image that are not fully transparent.
+     * @param image The image to take the shape of. Its color is ignored.
+     */
+    static BrushStamp fromImage(const QImage &image);
+
+    /**
+     * @brief Returns whether the stamp paints no pixels.
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Gets the canvas pixels the stamp covers when centered on a pixel.
+     * @param center The pixel the brush is on.
+     */
+    QRect footprint(QPoint center) const;
+
+    /**
+     * @brief Marks the pixels the stamp paints when centered on a pixel.
+     * @param center The pixel the brush is on.
+     * @param bounds The canvas area the mask covers.
+     * @param mask One byte per pixel of bounds, set to 1 where the stamp paints.
+     */
+    void stampInto(QPoint center, const QRect &bounds, std::vector<uchar> &mask) const;
+
+private:
+
+    // Makes a stamp of the given size with no pixels painted yet.
+    BrushStamp(int width, int height);
+
+    // The size of the stamp.
+    int width = 0;
+    int height = 0;
+
+    // The pixel of the stamp that lands on the brush position.
+    QPoint origin;
+
+    // One byte per pixel of the stamp, 1 where it paints.
+    std::vector<uchar> bits;
+
+    // The stamp for when its top left pixel lands on an odd pixel of the canvas, empty unless
+    // the stamp is patterned.
+    std::vector<uchar> oddBits;
+
+    // True if every pixel of the stamp paints, so rows can be filled without reading the mask.
+    bool solid = false;
+};
+
+#endif // BRUSHSTAMP_H
@@ -0,0 +1,362 @@
+/**
+ * Implementation of the CanvasViewport class, which zooms, pans and draws the canvas of a sprite.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer John Gibb
+ */
+
+#include "canvasviewport.h"
+#include "compositor.h"
+#include "pixelops.h"
+#include "tileset.h"
+
+#include <QLine>
+#include <QVector>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+// The zoom ladder in screen pixels per sprite pixel. Above 1 every level is a whole number so
+// all sprite pixels are drawn the same size.
+const double ZoomLevels[] = {1.0 / 16, 1.0 / 8, 1.0 / 4, 1.0 / 3, 1.0 / 2, 2.0 / 3,
+                             1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64};
+
+// The most kilobytes of scaled blocks kept across all zoom levels.
+const int CacheBudgetKb = 96 * 1024;
+
+// How many screen pixels of the sprite stay inside the widget however far it is panned.
+const int PanMargin = 64;
+}
+
+CanvasViewport::CanvasViewport()
+    : blocks(CacheBudgetKb)
+{
+
+}
+
+void CanvasViewport::setCanvasSize(int size)
+{
+    clearCache();
+    if (size != canvasSize)
+    {
+        canvasSize = size;
+        fit();
+    }
+}
+
+void CanvasViewport::setWidgetSize(const QSize &size)
+{
+    if (size == widgetSize)
+    {
+        return;
+    }
+
+    widgetSize = size;
+    if (view.fitted)
+    {
+        fit();
+    }
+    else
+    {
+        clampOffset();
+    }
+}
+
+CanvasViewport::View CanvasViewport::getView() const
+{
+    return view;
+}
+
+void CanvasViewport::setView(const View &newView)
+{
+    if (newView.fitted || newView.scale <= 0)
+    {
+        fit();
+        return;
+    }
+
+    view = newView;
+    clampOffset();
+}
+
+void CanvasViewport::fit()
+{
+    view.fitted = true;
+    if (canvasSize <= 0 || widgetSize.isEmpty())
+    {
+        view.scale = 1.0;
+        view.offset = QPoint();
+        return;
+    }
+
+    view.scale = double(qMin(widgetSize.width(), widgetSize.height())) / canvasSize;
+    view.offset = QPoint((widgetSize.width() - edge(canvasSize)) / 2,
+                         (widgetSize.height() - edge(canvasSize)) / 2);
+}
+
+bool CanvasViewport::zoomAt(int steps, const QPoint &anchor)
+{
+    double target = view.scale;
+    for (int i = 0; i < qAbs(steps); ++i)
+    {
+        target = nextScale(target, steps > 0);
+    }
+    if (target == view.scale || canvasSize <= 0)
+    {
+        return false;
+    }
+
+    // Zooming all the way out lands back on the fitted view
+    const double fitted = double(qMin(widgetSize.width(), widgetSize.height())) / canvasSize;
+    if (target == fitted)
+    {
+        fit();
+        return true;
+    }
+
+    // The sprite position under the anchor, kept in place across the zoom
+    const double spriteX = (anchor.x() - view.offset.x()) / view.scale;
+    const double spriteY = (anchor.y() - view.offset.y()) / view.scale;
+    view.scale = target;
+    view.fitted = false;
+    view.offset = QPoint(anchor.x() - int(std::floor(spriteX * target)),
+                         anchor.y() - int(std::floor(spriteY * target)));
+    clampOffset();
+    return true;
+}
+
+void CanvasViewport::panBy(const QPoint &delta)
+{
+    view.offset += delta;
+    view.fitted = false;
+    clampOffset();
+}
+
+double CanvasViewport::getScale() const
+{
+    return view.scale;
+}
+
+QPoint CanvasViewport::widgetToPixel(const QPoint &pos) const
+{
+    // Pixel p covers the screen distances from edge(p) up to, but not including, edge(p + 1)
+    const int dx = pos.x() - view.offset.x();
+    const int dy = pos.y() - view.offset.y();
+    return QPoint(int(std::ceil((dx + 1) / view.scale)) - 1,
+                  int(std::ceil((dy + 1) / view.scale)) - 1);
+}
+
+QRect CanvasViewport::pixelRectToWidget(const QRect &pixels) const
+{
+    return QRect(QPoint(view.offset.x() + edge(pixels.left()), view.offset.y() + edge(pixels.top())),
+                 QPoint(view.offset.x() + edge(pixels.right() + 1) - 1,
+                        view.offset.y() + edge(pixels.bottom() + 1) - 1));
+}
+
+void CanvasViewport::invalidate(const QRect &pixels)
+{
+    const QRect canvas(0, 0, canvasSize, canvasSize);
+    const QRect changed = pixels.intersected(canvas);
+    if (changed.isEmpty())
+    {
+        return;
+    }
+    if (changed == canvas)
+    {
+        clearCache();
+        return;
+    }
+
+    for (auto it = cachedScales.constBegin(); it != cachedScales.constEnd(); ++it)
+    {
+        const int size = it.value();
+        for (int row = changed.top() / size; row <= changed.bottom() / size; ++row)
+        {
+            for (int column = changed.left() / size; column <= changed.right() / size; ++column)
+            {
+                blocks.remove(quint64(it.key()) << 32 | quint64(row) << 16 | quint64(column));
+            }
+        }
+    }
+}
+
+void CanvasViewport::clearCache()
+{
+    blocks.clear();
+    cachedScales.clear();
+}
+
+void CanvasViewport::paint(QPainter &painter, const QRect &exposed, const QImage &image, const QImage &underlay)
+{
+    if (image.width() != canvasSize || canvasSize <= 0)
+    {
+        return;
+    }
+
+    const QRect visible = QRect(widgetToPixel(exposed.topLeft()), widgetToPixel(exposed.bottomRight()))
+                              .intersected(QRect(0, 0, canvasSize, canvasSize));
+    if (visible.isEmpty())
+    {
+        return;
+    }
+
+    const int size = blockSize();
+    for (int row = visible.top() / size; row <= visible.bottom() / size; ++row)
+    {
+        for (int column = visible.left() / size; column <= visible.right() / size; ++column)
+        {
+            painter.drawPixmap(view.offset + QPoint(edge(column * size), edge(row * size)),
+                               block(column, row, image, underlay));
+        }
+    }
+
+    if (view.scale >= GridMinScale)
+    {
+        drawGrid(painter, visible);
+    }
+}
+
+int CanvasViewport::blockSize() const
+{
+    // Zoomed out, blocks cover more of the sprite so there are never thousands of tiny pixmaps
+    int size = TileSet::TileSize;
+    while (size * view.scale < TileSet::TileSize && size < canvasSize)
+    {
+        size *= 2;
+    }
+    return size;
+}
+
+int CanvasViewport::edge(int pixel) const
+{
+    return int(std::floor(pixel * view.scale));
+}
+
+quint32 CanvasViewport::scaleKey() const
+{
+    return quint32(std::lround(view.scale * 4096));
+}
+
+double CanvasViewport::nextScale(double from, bool zoomIn) const
+{
+    double next = from;
+    auto consider = [&](double level) {
+        if (zoomIn ? level > from * 1.0001 && (next == from || level < next)
+                   : level < from * 0.9999 && (next == from || level > next))
+        {
+            next = level;
+        }
+    };
+
+    for (double level : ZoomLevels)
+    {
+        consider(level);
+    }
+    if (canvasSize > 0 && !widgetSize.isEmpty())
+    {
+        consider(double(qMin(widgetSize.width(), widgetSize.height())) / canvasSize);
+    }
+    return next;
+}
+
+void CanvasViewport::clampOffset()
+{
+    const int extent = edge(canvasSize);
+    const int margin = qMin(PanMargin, extent);
+    view.offset.setX(qBound(margin - extent, view.offset.x(), qMax(margin - extent, widgetSize.width() - margin)));
+    view.offset.setY(qBound(margin - extent, view.offset.y(), qMax(margin - extent, widgetSize.height() - margin)));
+}
+
+QPixmap CanvasViewport::block(int column, int row, const QImage &image, const QImage &underlay)
+{
+    const quint32 key = scaleKey();
+    const quint64 cacheKey = quint64(key) << 32 | quint64(row) << 16 | quint64(column);
+    if (const QPixmap *cached = blocks.object(cacheKey))
+    {
+        return *cached;
+    }
+
+    const int size = blockSize();
+    const QRect source = QRect(column * size, row * size, size, size).intersected(image.rect());
+    const int left = edge(source.left());
+    const int top = edge(source.top());
+    const QSize scaled(edge(source.right() + 1) - left, edge(source.bottom() + 1) - top);
+    if (scaled.isEmpty())
+    {
+        return QPixmap();
+    }
+
+    // Nearest neighbour: every screen pixel takes the sprite pixel it falls in
+    QVector<int> sourceX(scaled.width());
+    for (int x = 0; x < scaled.width(); ++x)
+    {
+        sourceX[x] = qMin(source.right(), int(std::ceil((left + x + 1) / view.scale)) - 1);
+    }
+
+    // With an underlay, each source row is blended over it once and then sampled
+    const bool blended = underlay.size() == image.size();
+    QVector<QRgb> composed(blended ? source.width() : 0);
+
+    QImage result(scaled, QImage::Format_ARGB32_Premultiplied);
+    int lastY = -1;
+    for (int y = 0; y < scaled.height(); ++y)
+    {
+        const int sourceY = qMin(source.bottom(), int(std::ceil((top + y + 1) / view.scale)) - 1);
+        QRgb *out = PixelOps::row(result, y);
+        if (sourceY == lastY)
+        {
+            // Rows of an enlarged pixel are identical, copy the one above
+            std::memcpy(out, PixelOps::constRow(result, y - 1), size_t(scaled.width()) * sizeof(QRgb));
+            continue;
+        }
+
+        const QRgb *in = PixelOps::constRow(image, sourceY);
+        int first = 0;
+        if (blended)
+        {
+            std::memcpy(composed.data(), PixelOps::constRow(underlay, sourceY) + source.left(),
+                        size_t(source.width()) * sizeof(QRgb));
+            Compositor::blendRow(composed.data(), in + source.left(), source.width(), 255, BlendMode::Normal);
+            in = composed.constData();
+            first = source.left();
+        }
+        for (int x = 0; x < scaled.width(); ++x)
+        {
+            out[x] = in[sourceX[x] - first];
+        }
+        lastY = sourceY;
+    }
+
+    const QPixmap pixmap = QPixmap::fromImage(std::move(result));
+    blocks.insert(cacheKey, new QPixmap(pixmap), qMax(1, scaled.width() * scaled.height() / 256));
+    cachedScales.insert(key, size);
+    return pixmap;
+}
+
+void CanvasViewport::drawGrid(QPainter &painter, const QRect &pixels) const
+{
+    const int top = view.offset.y() + edge(pixels.top());
+    const int bottom = view.offset.y() + edge(pixels.bottom() + 1);
+    const int left = view.offset.x() + edge(pixels.left());
+    const int right = view.offset.x() + edge(pixels.right() + 1);
+
+    QVector<QLine> lines;
+    lines.reserve(pixels.width() + pixels.height() + 2);
+    for (int x = pixels.left(); x <= pixels.right() + 1; ++x)
+    {
+        const int screenX = view.offset.x() + edge(x);
+        lines.append(QLine(screenX, top, screenX, bottom));
+    }
+    for (int y = pixels.top(); y <= pixels.bottom() + 1; ++y)
+    {
+        const int screenY = view.offset.y() + edge(y);
+        lines.append(QLine(left, screenY, right, screenY));
+    }
+
+    painter.save();
+    painter.setPen(QPen(QColor(128, 128, 128, 96), 0));
+    painter.drawLines(lines);
+    painter.restore();
+}
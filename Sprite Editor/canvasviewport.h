@@ -0,0 +1,178 @@
+/**
+ * Declaration of the CanvasViewport class, which zooms, pans and draws the canvas of a sprite.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer John Gibb
+ */
+
+#ifndef CANVASVIEWPORT_H
+#define CANVASVIEWPORT_H
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QPainter>
+#include <QPixmap>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+
+/**
+ * The CanvasViewport class maps between sprite pixels and widget coordinates and paints the
+ * visible part of a sprite. Rather than scaling the whole image on every paint, the sprite is
+ * split into blocks that are scaled once with nearest neighbour sampling and cached per zoom
+ * level, so panning only blits pixmaps that already exist. Blocks are 64x64 sprite pixels when
+ * zoomed in and grow by powers of two when zoomed out, keeping each cached pixmap at least 64
+ * screen pixels wide however large the sprite is. A pixel grid is drawn once pixels are big
+ * enough to tell apart.
+ */
+class CanvasViewport
+{
+public:
+
+    /**
+     * How the sprite is placed in the widget, shared between frames so switching frames keeps the view.
+     */
+    struct View
+    {
+        double scale = 1.0;     ///< Screen pixels per sprite pixel
+        QPoint offset;          ///< Where the top left corner of the sprite is drawn
+        bool fitted = true;     ///< Whether the sprite follows the widget size, centered
+    };
+
+    /**
+     * The smallest number of screen pixels per sprite pixel at which the pixel grid is drawn.
+     */
+    static const int GridMinScale = 8;
+
+    /**
+     * @brief Constructs a viewport for an empty canvas.
+     */
+    CanvasViewport();
+
+    /**
+     * @brief Sets the side length of the sprite shown. Drops every cached block, and fits the
+     * sprite to the widget again if its size changed.
+     * @param size The side length of the sprite in pixels.
+     */
+    void setCanvasSize(int size);
+
+    /**
+     * @brief Sets the size of the widget the sprite is drawn in.
+     * @param size The size of the widget.
+     */
+    void setWidgetSize(const QSize &size);
+
+    /**
+     * @brief Gets the current zoom and pan.
+     */
+    View getView() const;
+
+    /**
+     * @brief Restores a zoom and pan returned by getView.
+     * @param view The view to restore.
+     */
+    void setView(const View &view);
+
+    /**
+     * @brief Scales the sprite to fill the widget and centers it.
+     */
+    void fit();
+
+    /**
+     * @brief Zooms in or out by whole steps of the zoom ladder, keeping the sprite pixel under
+     * the anchor in place.
+     * @param steps Positive to zoom in, negative to zoom out.
+     * @param anchor The widget position that stays fixed.
+     * @return True if the zoom changed.
+     */
+    bool zoomAt(int steps, const QPoint &anchor);
+
+    /**
+     * @brief Moves the sprite within the widget. At least part of the sprite always stays visible.
+     * @param delta The distance to move in widget pixels.
+     */
+    void panBy(const QPoint &delta);
+
+    /**
+     * @brief Gets the number of screen pixels per sprite pixel.
+     */
+    double getScale() const;
+
+    /**
+     * @brief Finds the sprite pixel drawn at a widget position.
+     * @param pos The position in the widget.
+     * @return The sprite pixel, which lies outside the sprite if pos is not over it.
+     */
+    QPoint widgetToPixel(const QPoint &pos) const;
+
+    /**
+     * @brief Maps a rectangle of sprite pixels to the widget area they are drawn in.
+     * @param pixels The rectangle of sprite pixels.
+     * @return The rectangle of the widget covering them.
+     */
+    QRect pixelRectToWidget(const QRect &pixels) const;
+
+    /**
+     * @brief Drops the cached blocks of every zoom level that cover changed sprite pixels.
+     * @param pixels The rectangle of sprite pixels that changed.
+     */
+    void invalidate(const QRect &pixels);
+
+    /**
+     * @brief Drops every cached block.
+     */
+    void clearCache();
+
+    /**
+     * @brief Draws the part of the sprite inside a widget area, plus the pixel grid when zoomed in.
+     * @param painter The painter of the widget.
+     * @param exposed The widget area to draw.
+     * @param image The flattened premultiplied image of the sprite.
+     * @param underlay A premultiplied image the size of the sprite shown beneath it, or a null
+     * image for none. Blocks are cached with the underlay blended in, so clearCache must be
+     * called whenever it changes.
+     */
+    void paint(QPainter &painter, const QRect &exposed, const QImage &image, const QImage &underlay = QImage());
+
+private:
+
+    // The side length in sprite pixels of a cached block at the current scale.
+    int blockSize() const;
+
+    // The screen distance from the sprite's left or top edge to the edge of a sprite pixel.
+    int edge(int pixel) const;
+
+    // Identifies the current scale in cache keys.
+    quint32 scaleKey() const;
+
+    // Finds the next zoom level above or below a scale, the fitted scale included.
+    double nextScale(double from, bool zoomIn) const;
+
+    // Keeps part of the sprite within the widget.
+    void clampOffset();
+
+    // Gets a scaled block from the cache, scaling it over the underlay first if needed.
+    QPixmap block(int column, int row, const QImage &image, const QImage &underlay);
+
+    // Draws the lines between the visible sprite pixels.
+    void drawGrid(QPainter &painter, const QRect &pixels) const;
+
+    // The side length of the sprite in pixels.
+    int canvasSize = 0;
+
+    // The size of the widget the sprite is drawn in.
+    QSize widgetSize;
+
+    // The zoom and pan.
+    View view;
+
+    // Scaled blocks keyed by scale and block position, the cost being kilobytes of pixels.
+    QCache<quint64, QPixmap> blocks;
+
+    // The block size used by every scale that has blocks in the cache, for invalidation.
+    QHash<quint32, int> cachedScales;
+};
+
+#endif // CANVASVIEWPORT_H
@@ -0,0 +1,121 @@
+/**
+ * Implementation of the ColorPalette class, the shared colors of an indexed project.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Pierce Jones
+ */
+
+#include "colorpalette.h"
+#include "compositor.h"
+#include "pixelops.h"
+
+ColorPalette::ColorPalette()
+{
+
+}
+
+int ColorPalette::size() const
+{
+    return int(colors.size());
+}
+
+const QVector<QRgb> &ColorPalette::getColors() const
+{
+    return colors;
+}
+
+void ColorPalette::setColors(const QVector<QRgb> &newColors)
+{
+    colors = newColors.mid(0, MaxColors);
+    lookup.clear();
+    for (int i = int(colors.size()) - 1; i >= 0; --i)
+    {
+        lookup.insert(qPremultiply(colors[i]), i);    // Walking backwards leaves the first index
+    }
+}
+
+void ColorPalette::setColor(int index, QRgb color)
+{
+    if (index < 0 || index >= colors.size())
+    {
+        return;
+    }
+
+    QVector<QRgb> changed = colors;
+    changed[index] = color;
+    setColors(changed);
+}
+
+void ColorPalette::clear()
+{
+    colors.clear();
+    lookup.clear();
+}
+
+QImage ColorPalette::indexImage(const QImage &image)
+{
+    const QVector<QRgb> oldColors = colors;
+    QImage indexed(image.size(), QImage::Format_Indexed8);
+
+    // Pixel art repeats colors in runs, so the last lookup is reused before hashing
+    QRgb lastPixel = 0;
+    int lastIndex = -1;
+    for (int y = 0; y < image.height(); ++y)
+    {
+        const QRgb *in = PixelOps::constRow(image, y);
+        uchar *out = indexed.scanLine(y);
+        for (int x = 0; x < image.width(); ++x)
+        {
+            if (in[x] != lastPixel || lastIndex < 0)
+            {
+                lastPixel = in[x];
+                lastIndex = insertPremultiplied(lastPixel);
+                if (lastIndex < 0)
+                {
+                    setColors(oldColors);
+                    return QImage();
+                }
+            }
+            out[x] = uchar(lastIndex);
+        }
+    }
+
+    indexed.setColorTable(colors);
+    return indexed;
+}
+
+QImage ColorPalette::expandImage(const QImage &image)
+{
+    // Every index maps to its premultiplied color once, then each pixel is a single lookup
+    QRgb table[MaxColors] = {};
+    const QVector<QRgb> colorTable = image.colorTable();
+    for (int i = 0; i < colorTable.size() && i < MaxColors; ++i)
+    {
+        table[i] = qPremultiply(colorTable[i]);
+    }
+
+    QImage expanded(image.size(), QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < image.height(); ++y)
+    {
+        Compositor::expandIndexedRow(PixelOps::row(expanded, y), image.constScanLine(y), image.width(), table);
+    }
+    return expanded;
+}
+
+int ColorPalette::insertPremultiplied(QRgb pixel)
+{
+    const auto it = lookup.constFind(pixel);
+    if (it != lookup.constEnd())
+    {
+        return it.value();
+    }
+    if (colors.size() == MaxColors)
+    {
+        return -1;
+    }
+
+    colors.append(qUnpremultiply(pixel));
+    lookup.insert(pixel, int(colors.size()) - 1);
+    return int(colors.size()) - 1;
+}
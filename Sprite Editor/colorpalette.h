@@ -0,0 +1,93 @@
+/**
+ * Declaration of the ColorPalette class, the shared colors of an indexed project.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Pierce Jones
+ */
+
+#ifndef COLORPALETTE_H
+#define COLORPALETTE_H
+
+#include <QHash>
+#include <QImage>
+#include <QVector>
+
+/**
+ * The ColorPalette class holds up to 256 colors shared by every frame of a project. In indexed
+ * mode, layers are stored as 8-bit images holding a position in the palette for each pixel, with
+ * the palette as their color table. Changing a color of the palette then recolors every frame
+ * by swapping color tables, without touching a single pixel.
+ */
+class ColorPalette
+{
+public:
+
+    /**
+     * The most colors a palette can hold, one per value of an index byte.
+     */
+    static const int MaxColors = 256;
+
+    /**
+     * @brief Constructs an empty palette.
+     */
+    ColorPalette();
+
+    /**
+     * @brief Gets the number of colors in the palette.
+     */
+    int size() const;
+
+    /**
+     * @brief Gets the colors of the palette in index order.
+     * @return Non-premultiplied ARGB32 colors, usable as the color table of an 8-bit image.
+     */
+    const QVector<QRgb> &getColors() const;
+
+    /**
+     * @brief Replaces every color of the palette.
+     * @param colors The new non-premultiplied ARGB32 colors, only the first MaxColors are kept.
+     */
+    void setColors(const QVector<QRgb> &colors);
+
+    /**
+     * @brief Changes a single color of the palette, keeping its index.
+     * @param index The index of the color to change.
+     * @param color The new non-premultiplied ARGB32 color.
+     */
+    void setColor(int index, QRgb color);
+
+    /**
+     * @brief Removes every color.
+     */
+    void clear();
+
+    /**
+     * @brief Converts a premultiplied image into an 8-bit image of palette indices, adding any
+     * colors the palette does not have yet.
+     * @param image The premultiplied ARGB32 image to convert.
+     * @return The indexed image with the palette as its color table, or a null image, leaving the
+     * palette unchanged, if its colors would not fit in the palette.
+     */
+    QImage indexImage(const QImage &image);
+
+    /**
+     * @brief Converts an 8-bit indexed image back to premultiplied ARGB32 through its color table.
+     * @param image The indexed image.
+     * @return The premultiplied image.
+     */
+    static QImage expandImage(const QImage &image);
+
+private:
+
+    // Adds a color given premultiplied, returning its index or -1 if the palette is full.
+    int insertPremultiplied(QRgb pixel);
+
+    // The colors in index order, non-premultiplied.
+    QVector<QRgb> colors;
+
+    // The index of the first palette color with each premultiplied value.
+    QHash<QRgb, int> lookup;
+};
+
+#endif // COLORPALETTE_H
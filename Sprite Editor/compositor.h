@@ -0,0 +1,343 @@
+/**
+ * Layer compositing on premultiplied 32-bit scanlines.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Golightly Chamberlain
+ */
+
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <QImage>
+#include <QRect>
+#include <QRgb>
+#include <QVector>
+#include <vector>
+#include "layer.h"
+#include "pixelops.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * The Compositor functions blend layers together a row at a time. All blending happens on
+ * premultiplied ARGB, where every blend mode reduces to a few multiplies and adds per channel.
+ * Four pixels are blended at a time with SSE2 where available, with a scalar loop for the
+ * remainder and for other targets.
+ */
+namespace Compositor
+{
+
+/**
+ * @brief div255 Divides by 255 with rounding, exact for every product of two 8-bit values.
+ */
+inline uint div255(uint x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+/**
+ * @brief scalePixel Multiplies every channel of a premultiplied pixel by an opacity.
+ * @param pixel The premultiplied pixel.
+ * @param opacity 0 to 255.
+ * @return The faded pixel, still premultiplied.
+ */
+inline QRgb scalePixel(QRgb pixel, int opacity)
+{
+    return div255(qAlpha(pixel) * uint(opacity)) << 24
+           | div255(qRed(pixel) * uint(opacity)) << 16
+           | div255(qGreen(pixel) * uint(opacity)) << 8
+           | div255(qBlue(pixel) * uint(opacity));
+}
+
+/**
+ * @brief blendPixel Blends one premultiplied pixel over another.
+ * @param source The pixel of the upper layer.
+ * @param dest The pixel of the layers below.
+ * @param mode How the two combine.
+ * @return The blended pixel, premultiplied.
+ */
+inline QRgb blendPixel(QRgb source, QRgb dest, BlendMode mode)
+{
+    const uint sourceAlpha = qAlpha(source);
+    const uint destAlpha = qAlpha(dest);
+    QRgb result = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        const uint s = (source >> shift) & 0xFF;
+        const uint d = (dest >> shift) & 0xFF;
+        uint c = 0;
+        switch (mode)
+        {
+        case BlendMode::Normal:
+            c = s + div255(d * (255 - sourceAlpha));
+            break;
+        case BlendMode::Multiply:
+            c = div255(s * d + s * (255 - destAlpha) + d * (255 - sourceAlpha));
+            break;
+        case BlendMode::Screen:
+            c = s + d - div255(s * d);
+            break;
+        case BlendMode::Add:
+            c = qMin(255u, s + d);
+            break;
+        }
+        result |= c << shift;
+    }
+    return result;
+}
+
+#if defined(__SSE2__)
+/**
+ * @brief div255 Divides eight 16-bit lanes by 255 with rounding.
+ */
+inline __m128i div255(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/**
+ * @brief alphaOf Copies the alpha of two pixels unpacked to 16-bit lanes into all four of their lanes.
+ */
+inline __m128i alphaOf(__m128i pixels)
+{
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/**
+ * @brief blendUnpacked Blends two premultiplied pixels unpacked to 16-bit lanes over two others.
+ * Every intermediate stays below 65536 because premultiplied channels never exceed their alpha.
+ */
+inline __m128i blendUnpacked(__m128i s, __m128i d, BlendMode mode)
+{
+    const __m128i full = _mm_set1_epi16(255);
+    switch (mode)
+    {
+    case BlendMode::Multiply:
+    {
+        __m128i sum = _mm_add_epi16(_mm_mullo_epi16(s, d),
+                                    _mm_mullo_epi16(s, _mm_sub_epi16(full, alphaOf(d))));
+        sum = _mm_add_epi16(sum, _mm_mullo_epi16(d, _mm_sub_epi16(full, alphaOf(s))));
+        return div255(sum);
+    }
+    case BlendMode::Screen:
+        return _mm_sub_epi16(_mm_add_epi16(s, d), div255(_mm_mullo_epi16(s, d)));
+    case BlendMode::Add:
+        return _mm_min_epi16(_mm_add_epi16(s, d), full);
+    case BlendMode::Normal:
+    default:
+        return _mm_add_epi16(s, div255(_mm_mullo_epi16(d, _mm_sub_epi16(full, alphaOf(s)))));
+    }
+}
+#endif
+
+/**
+ * @brief blendRow Blends a row of premultiplied pixels over another.
+ * @param dest The premultiplied row of the layers below, overwritten with the result.
+ * @param source The premultiplied row of the upper layer.
+ * @param count The number of pixels in the row.
+ * @param opacity The opacity of the upper layer, 0 to 255.
+ * @param mode How the two rows combine.
+ */
+inline void blendRow(QRgb *dest, const QRgb *source, int count, int opacity, BlendMode mode)
+{
+    int x = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(int(0xFF000000));
+    const __m128i fade = _mm_set1_epi16(short(opacity));
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x));
+        __m128i alphas = _mm_and_si128(s, alphaMask);
+
+        // Transparent pixels leave the layers below unchanged in every mode
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alphas, zero)) == 0xFFFF)
+        {
+            continue;
+        }
+
+        // Opaque pixels painted normally simply replace what is below
+        if (mode == BlendMode::Normal && opacity == 255
+            && _mm_movemask_epi8(_mm_cmpeq_epi32(alphas, alphaMask)) == 0xFFFF)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x), s);
+            continue;
+        }
+
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest + x));
+        __m128i sourceLow = _mm_unpacklo_epi8(s, zero);
+        __m128i sourceHigh = _mm_unpackhi_epi8(s, zero);
+        if (opacity < 255)
+        {
+            sourceLow = div255(_mm_mullo_epi16(sourceLow, fade));
+            sourceHigh = div255(_mm_mullo_epi16(sourceHigh, fade));
+        }
+
+        __m128i low = blendUnpacked(sourceLow, _mm_unpacklo_epi8(d, zero), mode);
+        __m128i high = blendUnpacked(sourceHigh, _mm_unpackhi_epi8(d, zero), mode);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x), _mm_packus_epi16(low, high));
+    }
+#endif
+
+    for (; x < count; ++x)
+    {
+        QRgb s = source[x];
+        if (qAlpha(s) == 0)
+        {
+            continue;
+        }
+        if (opacity < 255)
+        {
+            s = scalePixel(s, opacity);
+        }
+        dest[x] = blendPixel(s, dest[x], mode);
+    }
+}
+
+/**
+ * @brief premultiplyRow Converts a row of ARGB32 pixels to premultiplied ARGB.
+ * @param dest The row to write.
+ * @param source The ARGB32 row to read.
+ * @param count The number of pixels in the row.
+ */
+inline void premultiplyRow(QRgb *dest, const QRgb *source, int count)
+{
+    for (int x = 0; x < count; ++x)
+    {
+        dest[x] = qPremultiply(source[x]);
+    }
+}
+
+/**
+ * @brief expandIndexedRow Converts a row of 8-bit palette indices to premultiplied ARGB.
+ * @param dest The row to write.
+ * @param source The row of indices to read.
+ * @param count The number of pixels in the row.
+ * @param table The premultiplied color of each of the 256 indices.
+ */
+inline void expandIndexedRow(QRgb *dest, const uchar *source, int count, const QRgb *table)
+{
+    for (int x = 0; x < count; ++x)
+    {
+        dest[x] = table[source[x]];
+    }
+}
+
+/**
+ * @brief flatten Composites the visible layers inside a rectangle, bottom layer first.
+ * Layers may be ARGB32, premultiplied ARGB32 or 8-bit indexed through their color table.
+ * Layers that are not the size of dest are skipped, as are the tiles outside a layer's occupied set.
+ * @param dest The ARGB32_Premultiplied image to write.
+ * @param layers The layers to composite, bottom layer first.
+ * @param rect The rectangle to composite.
+ */
+inline void flatten(QImage &dest, const QVector<Layer> &layers, const QRect &rect)
+{
+    const QRect clipped = rect.intersected(dest.rect());
+    if (clipped.isEmpty())
+    {
+        return;
+    }
+
+    PixelOps::fillRect(dest, clipped, 0);
+    std::vector<QRgb> scratch(clipped.width());
+
+    for (const Layer &layer : layers)
+    {
+        if (!layer.visible || layer.opacity <= 0 || layer.image.size() != dest.size())
+        {
+            continue;
+        }
+
+        // Indexed layers are looked up through their color table, premultiplied once per layer
+        const bool indexed = layer.image.format() == QImage::Format_Indexed8;
+        QRgb table[256] = {};
+        if (indexed)
+        {
+            const QVector<QRgb> colors = layer.image.colorTable();
+            for (int i = 0; i < colors.size() && i < 256; ++i)
+            {
+                table[i] = qPremultiply(colors[i]);
+            }
+        }
+
+        // Tiles the layer never painted are transparent, which leaves dest unchanged in every mode
+        const bool premultiplied = layer.image.format() == QImage::Format_ARGB32_Premultiplied;
+        for (const QRect &part : layer.occupied.rects(clipped))
+        {
+            for (int y = part.top(); y <= part.bottom(); ++y)
+            {
+                const QRgb *source = scratch.data();
+                if (indexed)
+                {
+                    expandIndexedRow(scratch.data(), layer.image.constScanLine(y) + part.left(), part.width(), table);
+                }
+                else if (premultiplied)
+                {
+                    source = PixelOps::constRow(layer.image, y) + part.left();
+                }
+                else
+                {
+                    premultiplyRow(scratch.data(), PixelOps::constRow(layer.image, y) + part.left(), part.width());
+                }
+                blendRow(PixelOps::row(dest, y) + part.left(), source, part.width(),
+                         layer.opacity, layer.blendMode);
+            }
+        }
+    }
+}
+
+/**
+ * @brief visibleTiles Gets the tiles any visible layer may have painted, outside of which the
+ * composite is fully transparent.
+ * @param layers The layers to composite, bottom layer first.
+ * @param size The size of the composite.
+ * @return The tiles of the composite that may hold visible pixels.
+ */
+inline TileSet visibleTiles(const QVector<Layer> &layers, const QSize &size)
+{
+    TileSet tiles(size);
+    const QRect all(QPoint(0, 0), size);
+    for (const Layer &layer : layers)
+    {
+        if (layer.visible && layer.opacity > 0 && layer.image.size() == size)
+        {
+            for (const QRect &part : layer.occupied.rects(all))
+            {
+                tiles.insert(part);
+            }
+        }
+    }
+    return tiles;
+}
+
+/**
+ * @brief flattened Composites all visible layers into a new image. The image starts out blank,
+ * so only the tiles some layer painted are composited or even touched.
+ * @param layers The layers to composite, bottom layer first.
+ * @return The ARGB32_Premultiplied composite, or a null image if there are no layers.
+ */
+inline QImage flattened(const QVector<Layer> &layers)
+{
+    if (layers.isEmpty())
+    {
+        return QImage();
+    }
+
+    QImage result = PixelOps::blankImage(layers.first().image.size(), QImage::Format_ARGB32_Premultiplied);
+    for (const QRect &part : visibleTiles(layers, result.size()).rects(result.rect()))
+    {
+        flatten(result, layers, part);
+    }
+    return result;
+}
+
+}
+
+#endif // COMPOSITOR_H
@@ -0,0 +1,235 @@
+/**
+ * Implementation of the Diagnostics class, which times editor work for the diagnostics overlay and trace.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Matthew Shaw
+ */
+
+#include "diagnostics.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+
+namespace
+{
+// A timed section or counter value in the log.
+struct Event
+{
+    const char *name;
+    const char *category;
+    qint64 start;       // Nanoseconds since the clock started
+    qint64 duration;    // In nanoseconds, for timed sections
+    quintptr thread;
+    QVector<QPair<QString, qint64>> series;    // Every value of a counter, empty for timed sections
+};
+
+// The running totals behind Diagnostics::Stats.
+struct Totals
+{
+    int count = 0;
+    qint64 last = 0;
+    qint64 total = 0;
+    qint64 max = 0;
+};
+
+// Everything recorded, shared by every thread.
+struct Recorder
+{
+    QMutex mutex;
+    QElapsedTimer clock;
+    QVector<Event> events;
+    int next = 0;       // Where the next event goes once the log is full
+    QHash<QByteArray, Totals> totals;
+
+    Recorder()
+    {
+        clock.start();
+    }
+
+    void append(Event &&event)
+    {
+        if (events.size() < Diagnostics::MaxEvents)
+        {
+            events.append(std::move(event));
+            return;
+        }
+        events[next] = std::move(event);
+        next = (next + 1) % Diagnostics::MaxEvents;
+    }
+};
+
+Recorder &recorder()
+{
+    static Recorder instance;
+    return instance;
+}
+
+std::atomic<bool> recording(false);
+
+// Records a section that ran from start for duration nanoseconds.
+void record(const char *name, const char *category, qint64 start, qint64 duration)
+{
+    Recorder &r = recorder();
+    const quintptr thread = quintptr(QThread::currentThreadId());
+    QMutexLocker locker(&r.mutex);
+
+    Totals &totals = r.totals[QByteArray(name)];
+    totals.count++;
+    totals.last = duration;
+    totals.total += duration;
+    totals.max = qMax(totals.max, duration);
+
+    r.append({name, category, start, duration, thread, {}});
+}
+}
+
+Diagnostics::Scope::Scope(const char *name, const char *category)
+    : name(name)
+    , category(category)
+    , start(Diagnostics::isEnabled() ? Diagnostics::now() : -1)
+{
+
+}
+
+Diagnostics::Scope::~Scope()
+{
+    if (start >= 0)
+    {
+        record(name, category, start, Diagnostics::now() - start);
+    }
+}
+
+void Diagnostics::setEnabled(bool enabled)
+{
+    recorder();     // Starts the clock before the first timestamp is taken
+    recording.store(enabled, std::memory_order_relaxed);
+}
+
+bool Diagnostics::isEnabled()
+{
+    return recording.load(std::memory_order_relaxed);
+}
+
+qint64 Diagnostics::now()
+{
+    return recorder().clock.nsecsElapsed();
+}
+
+void Diagnostics::recordSince(const char *name, const char *category, qint64 start)
+{
+    if (isEnabled())
+    {
+        record(name, category, start, now() - start);
+    }
+}
+
+void Diagnostics::counter(const char *name, const QString &series, qint64 value)
+{
+    counter(name, {{series, value}});
+}
+
+void Diagnostics::counter(const char *name, const QVector<QPair<QString, qint64>> &series)
+{
+    if (!isEnabled() || series.isEmpty())
+    {
+        return;
+    }
+
+    Recorder &r = recorder();
+    const qint64 timestamp = now();
+    const quintptr thread = quintptr(QThread::currentThreadId());
+    QMutexLocker locker(&r.mutex);
+    r.append({name, "memory", timestamp, 0, thread, series});
+}
+
+Diagnostics::Stats Diagnostics::getStats(const char *name)
+{
+    Recorder &r = recorder();
+    QMutexLocker locker(&r.mutex);
+    const Totals totals = r.totals.value(QByteArray(name));
+
+    Stats stats;
+    stats.count = totals.count;
+    stats.lastMs = totals.last / 1e6;
+    stats.averageMs = totals.count > 0 ? totals.total / 1e6 / totals.count : 0;
+    stats.maxMs = totals.max / 1e6;
+    return stats;
+}
+
+void Diagnostics::clear()
+{
+    Recorder &r = recorder();
+    QMutexLocker locker(&r.mutex);
+    r.events.clear();
+    r.next = 0;
+    r.totals.clear();
+}
+
+bool Diagnostics::exportTrace(const QString &fileName)
+{
+    QVector<Event> events;
+    int next;
+    {
+        Recorder &r = recorder();
+        QMutexLocker locker(&r.mutex);
+        events = r.events;
+        next = r.next;
+    }
+
+    // Complete events for timed sections and counter events for values, timestamps in microseconds
+    QJsonArray traceEvents;
+    QHash<quintptr, int> threadIds;
+    for (int i = 0; i < events.size(); ++i)
+    {
+        const Event &event = events[(next + i) % events.size()];
+        if (!threadIds.contains(event.thread))
+        {
+            threadIds.insert(event.thread, int(threadIds.size()) + 1);   // Small stable ids read better than addresses
+        }
+
+        QJsonObject object;
+        object["name"] = QString::fromLatin1(event.name);
+        object["cat"] = QString::fromLatin1(event.category);
+        object["ts"] = event.start / 1000.0;
+        object["pid"] = 1;
+        object["tid"] = threadIds.value(event.thread);
+        if (event.series.isEmpty())
+        {
+            object["ph"] = "X";
+            object["dur"] = event.duration / 1000.0;
+        }
+        else
+        {
+            // Viewers fill series missing from a counter event with 0, so each event holds all of them
+            QJsonObject args;
+            for (const auto &value : event.series)
+            {
+                args[value.first] = double(value.second);
+            }
+            object["ph"] = "C";
+            object["args"] = args;
+        }
+        traceEvents.append(object);
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Could not open" << fileName << "for writing";
+        return false;
+    }
+
+    const QJsonObject root{{"traceEvents", traceEvents}, {"displayTimeUnit", "ms"}};
+    return file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) >= 0;
+}
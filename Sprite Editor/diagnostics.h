@@ -0,0 +1,141 @@
+/**
+ * Declaration of the Diagnostics class, which times editor work for the diagnostics overlay and trace.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Matthew Shaw
+ */
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * The Diagnostics class records how long the editor spends on its work and how much memory it
+ * holds, from any thread. Timed sections are measured with QElapsedTimer and kept both as running
+ * statistics per name, shown by the overlay, and as a bounded log of events that can be exported
+ * as Chrome trace JSON and opened in chrome://tracing or Perfetto. Recording is off until enabled,
+ * and while off every call returns after a single atomic load.
+ *
+ * Names and categories must be string literals, as only their pointers are kept.
+ */
+class Diagnostics
+{
+public:
+
+    /**
+     * The number of events kept in the log. Once full, the oldest events are overwritten.
+     */
+    static const int MaxEvents = 100000;
+
+    /**
+     * Running statistics of one kind of timed section, in milliseconds.
+     */
+    struct Stats
+    {
+        int count = 0;          ///< How many times the section was recorded
+        double lastMs = 0;      ///< The duration of the latest one
+        double averageMs = 0;   ///< The mean duration
+        double maxMs = 0;       ///< The longest duration
+    };
+
+    /**
+     * Times the enclosing block and records it when it goes out of scope.
+     */
+    class Scope
+    {
+    public:
+
+        /**
+         * @brief Starts timing, if recording is enabled.
+         * @param name What is being timed.
+         * @param category The part of the editor doing the work.
+         */
+        Scope(const char *name, const char *category);
+
+        /**
+         * @brief Records the time since construction.
+         */
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+
+        // What is being timed.
+        const char *name;
+
+        // The part of the editor doing the work.
+        const char *category;
+
+        // When timing started, or -1 if recording was off.
+        qint64 start;
+    };
+
+    /**
+     * @brief Turns recording on or off. Recorded events and statistics are kept either way.
+     * @param enabled Whether to record.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * @brief Returns whether recording is on.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Gets a timestamp for record.
+     * @return Nanoseconds since the first use of Diagnostics.
+     */
+    static qint64 now();
+
+    /**
+     * @brief Records a section that started at a known time and has just ended, such as the
+     * wait between a mouse event and the paint that shows it.
+     * @param name What was timed.
+     * @param category The part of the editor doing the work.
+     * @param start When the section started, from now().
+     */
+    static void recordSince(const char *name, const char *category, qint64 start);
+
+    /**
+     * @brief Records the current value of a counter, such as bytes of memory in use.
+     * @param name The counter.
+     * @param series Which of the counter's values this is, such as a frame.
+     * @param value The value.
+     */
+    static void counter(const char *name, const QString &series, qint64 value);
+
+    /**
+     * @brief Records the current values of a counter with several series as a single event. Trace
+     * viewers show a series missing from an event as 0, so every series is recorded each time.
+     * @param name The counter.
+     * @param series Each series of the counter and its value.
+     */
+    static void counter(const char *name, const QVector<QPair<QString, qint64>> &series);
+
+    /**
+     * @brief Gets the statistics of a kind of timed section.
+     * @param name The name the sections were recorded with.
+     */
+    static Stats getStats(const char *name);
+
+    /**
+     * @brief Forgets every recorded event and statistic.
+     */
+    static void clear();
+
+    /**
+     * @brief Writes the recorded events as Chrome trace JSON.
+     * @param fileName The path of the .json file.
+     * @return True if the file was written.
+     */
+    static bool exportTrace(const QString &fileName);
+};
+
+#endif // DIAGNOSTICS_H
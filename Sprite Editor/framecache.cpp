@@ -0,0 +1,51 @@
+/**
+ * Implementation of the FrameCache class, which keeps ready-to-draw pixmaps of frames.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Matthew Shaw
+ */
+
+#include "framecache.h"
+
+#include <QSet>
+
+FrameCache::FrameCache(QSize targetSize)
+    : targetSize(targetSize)
+{
+
+}
+
+void FrameCache::setTargetSize(QSize size)
+{
+    if (size != targetSize)
+    {
+        targetSize = size;
+        entries.clear();
+    }
+}
+
+const QPixmap &FrameCache::pixmap(const Sprite *frame)
+{
+    Entry &entry = entries[frame];
+    if (entry.pixmap.isNull() || entry.version != frame->getVersion())
+    {
+        const QImage &img = frame->getImage();
+        entry.version = frame->getVersion();
+        entry.pixmap = QPixmap::fromImage(targetSize.isEmpty()
+                                              ? img
+                                              : img.scaled(targetSize,
+                                                           Qt::KeepAspectRatio,
+                                                           Qt::FastTransformation));
+    }
+    return entry.pixmap;
+}
+
+void FrameCache::retain(const QVector<Sprite *> &frames)
+{
+    QSet<const Sprite *> live(frames.cbegin(), frames.cend());
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        it = live.contains(it.key()) ? std::next(it) : entries.erase(it);
+    }
+}
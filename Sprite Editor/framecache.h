@@ -0,0 +1,68 @@
+/**
+ * Declaration of the FrameCache class, which keeps ready-to-draw pixmaps of frames.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Matthew Shaw
+ */
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <QHash>
+#include <QPixmap>
+#include <QSize>
+#include <QVector>
+#include "sprite.h"
+
+/**
+ * The FrameCache class converts frames to device-native pixmaps, scaled to fit a target
+ * size, and keeps them for reuse. A frame is only converted again once its version changes,
+ * so animation playback draws straight from the cache instead of converting every tick.
+ */
+class FrameCache
+{
+public:
+
+    /**
+     * @brief Constructs an empty cache.
+     * @param targetSize The size frames are scaled to fit, or an empty size to keep their pixel size.
+     */
+    explicit FrameCache(QSize targetSize = QSize());
+
+    /**
+     * @brief Changes the size frames are scaled to fit, dropping every cached pixmap if it differs.
+     * @param size The new target size, or an empty size to keep the pixel size of frames.
+     */
+    void setTargetSize(QSize size);
+
+    /**
+     * @brief Gets the pixmap of a frame, converting it only if it changed since it was cached.
+     * @param frame The frame to get.
+     * @return The cached pixmap of the frame.
+     */
+    const QPixmap &pixmap(const Sprite *frame);
+
+    /**
+     * @brief Drops the pixmaps of every frame not in the given list.
+     * @param frames The frames that are still in use.
+     */
+    void retain(const QVector<Sprite *> &frames);
+
+private:
+
+    // A converted frame along with the version it was converted from.
+    struct Entry
+    {
+        quint64 version = 0;
+        QPixmap pixmap;
+    };
+
+    // The size frames are scaled to fit, empty to keep their pixel size.
+    QSize targetSize;
+
+    // The converted pixmap of each frame.
+    QHash<const Sprite *, Entry> entries;
+};
+
+#endif // FRAMECACHE_H
@@ -0,0 +1,141 @@
+/**
+ * Implementation of the FrameScheduler class, which paces animation playback.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Cheuk Yin Lau
+ */
+
+#include "framescheduler.h"
+
+#include <QtMath>
+
+FrameScheduler::FrameScheduler(QObject *parent)
+    : QObject(parent)
+{
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer,
+            &QTimer::timeout,
+            this,
+            &FrameScheduler::tick);
+}
+
+void FrameScheduler::setFps(double newFps)
+{
+    fps = qMax(1.0, newFps);
+    if (isActive())
+    {
+        scheduleNextTick();
+    }
+}
+
+void FrameScheduler::setFrameCount(int count)
+{
+    frameCount = qMax(0, count);
+    if (currentFrame >= frameCount)
+    {
+        currentFrame = 0;
+        accumulatedMs = 0;
+    }
+}
+
+void FrameScheduler::setFrameDurations(const QVector<double> &durationsMs)
+{
+    frameDurations = durationsMs;
+}
+
+void FrameScheduler::start()
+{
+    clock.start();
+    lastTickNs = 0;
+    windowStartNs = 0;
+    shownInWindow = 0;
+    accumulatedMs = 0;
+
+    if (frameCount > 0)
+    {
+        emit frameChanged(currentFrame);
+    }
+    scheduleNextTick();
+}
+
+void FrameScheduler::stop()
+{
+    timer.stop();
+}
+
+bool FrameScheduler::isActive() const
+{
+    return timer.isActive();
+}
+
+int FrameScheduler::getCurrentFrame() const
+{
+    return currentFrame;
+}
+
+double FrameScheduler::getMeasuredFps() const
+{
+    return measuredFps;
+}
+
+int FrameScheduler::getDroppedFrames() const
+{
+    return droppedFrames;
+}
+
+void FrameScheduler::tick()
+{
+    const qint64 now = clock.nsecsElapsed();
+    accumulatedMs += (now - lastTickNs) / 1e6;
+    lastTickNs = now;
+
+    // Step over every frame whose time has fully passed
+    int advanced = 0;
+    while (frameCount > 0 && accumulatedMs >= durationOf(currentFrame))
+    {
+        accumulatedMs -= durationOf(currentFrame);
+        currentFrame = (currentFrame + 1) % frameCount;
+        advanced++;
+
+        // After a long stall (e.g. a suspended machine) resync instead of racing through
+        if (advanced > frameCount)
+        {
+            accumulatedMs = 0;
+            break;
+        }
+    }
+
+    if (advanced > 0)
+    {
+        droppedFrames += advanced - 1;
+        shownInWindow++;
+        emit frameChanged(currentFrame);
+    }
+
+    if (now - windowStartNs >= 1000000000)
+    {
+        measuredFps = shownInWindow * 1e9 / (now - windowStartNs);
+        shownInWindow = 0;
+        windowStartNs = now;
+    }
+
+    scheduleNextTick();
+}
+
+double FrameScheduler::durationOf(int frame) const
+{
+    if (frame < frameDurations.size() && frameDurations[frame] > 0)
+    {
+        return frameDurations[frame];
+    }
+    return 1000.0 / fps;
+}
+
+void FrameScheduler::scheduleNextTick()
+{
+    // Wake up when the current frame runs out rather than on a fixed interval
+    double remaining = frameCount > 0 ? durationOf(currentFrame) - accumulatedMs : 1000.0 / fps;
+    timer.start(qMax(1, qCeil(remaining)));
+}
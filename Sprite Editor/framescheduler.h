@@ -0,0 +1,144 @@
+/**
+ * Declaration of the FrameScheduler class, which paces animation playback.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Cheuk Yin Lau
+ */
+
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * The FrameScheduler class decides which animation frame should be on screen. Rather than
+ * stepping once per timer tick, it measures real elapsed time with a QElapsedTimer and
+ * accumulates it against the duration of the current frame, so rounding and timer jitter
+ * never add up to drift. When ticks arrive late, overdue frames are skipped and counted as
+ * dropped. Frames can share one rate or each have their own duration.
+ */
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * @brief Constructs a stopped scheduler at 1 FPS with no frames.
+     * @param parent Optional QObject parent.
+     */
+    explicit FrameScheduler(QObject *parent = nullptr);
+
+    /**
+     * @brief Sets the rate used by frames without their own duration.
+     * @param fps Frames per second, values below 1 are treated as 1.
+     */
+    void setFps(double fps);
+
+    /**
+     * @brief Sets how many frames the animation has, restarting from the first frame if
+     * the current one no longer exists.
+     * @param count The number of frames.
+     */
+    void setFrameCount(int count);
+
+    /**
+     * @brief Gives frames their own display durations.
+     * @param durationsMs The duration of each frame in milliseconds. Frames past the end of
+     * the list, or with a duration of 0 or less, use the rate set by setFps.
+     */
+    void setFrameDurations(const QVector<double> &durationsMs);
+
+    /**
+     * @brief Starts playback from the current frame, which is shown immediately.
+     */
+    void start();
+
+    /**
+     * @brief Stops playback, keeping the current frame.
+     */
+    void stop();
+
+    /**
+     * @brief Returns whether playback is running.
+     */
+    bool isActive() const;
+
+    /**
+     * @brief Gets the frame that should currently be shown.
+     */
+    int getCurrentFrame() const;
+
+    /**
+     * @brief Gets the rate frames were actually shown at, measured over the last second.
+     */
+    double getMeasuredFps() const;
+
+    /**
+     * @brief Gets how many frames were skipped because playback fell behind.
+     */
+    int getDroppedFrames() const;
+
+signals:
+
+    /**
+     * @brief Signals that a new frame should be shown.
+     * @param frameIndex The index of the frame to show.
+     */
+    void frameChanged(int frameIndex);
+
+private slots:
+
+    // Advances by however many frames the elapsed time covers and schedules the next tick.
+    void tick();
+
+private:
+
+    // The display duration of a frame in milliseconds.
+    double durationOf(int frame) const;
+
+    // Arms the timer for when the current frame runs out.
+    void scheduleNextTick();
+
+    // Single-shot precise timer that wakes the scheduler.
+    QTimer timer;
+
+    // Measures real time since playback started.
+    QElapsedTimer clock;
+
+    // Clock reading at the previous tick, in nanoseconds.
+    qint64 lastTickNs = 0;
+
+    // Time the current frame has been on screen, in milliseconds.
+    double accumulatedMs = 0;
+
+    // The rate used by frames without their own duration.
+    double fps = 1;
+
+    // Per-frame durations in milliseconds.
+    QVector<double> frameDurations;
+
+    // The number of frames in the animation.
+    int frameCount = 0;
+
+    // The frame that should currently be shown.
+    int currentFrame = 0;
+
+    // Frames skipped because playback fell behind.
+    int droppedFrames = 0;
+
+    // Frames shown since the measurement window started.
+    int shownInWindow = 0;
+
+    // Clock reading when the measurement window started, in nanoseconds.
+    qint64 windowStartNs = 0;
+
+    // The last measured rate.
+    double measuredFps = 0;
+};
+
+#endif // FRAMESCHEDULER_H
@@ -0,0 +1,179 @@
+/**
+ * Implementation of the FrameStore class and StoredFrame struct, which keep frames encoded until they are needed.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Golightly Chamberlain
+ */
+
+#include "framestore.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+FrameStore::FrameStore(const QString &fileName)
+    : project(fileName)
+    , fileName(fileName)
+{
+
+}
+
+bool FrameStore::open()
+{
+    QMutexLocker locker(&mutex);
+    if (!project.openForRead())
+    {
+        return false;
+    }
+    if (project.isLegacyJson() || !project.indexRecords())
+    {
+        project.close();
+        return false;
+    }
+
+    const QFileInfo info(fileName);
+    modified = info.lastModified();
+    fileSize = info.size();
+    frameCount = project.getFrameCount();
+    spriteSize = project.getSpriteSize();
+    palette = project.getPalette();
+    sourceFrames.clear();
+    for (int i = 0; i < frameCount; ++i)
+    {
+        sourceFrames.append(project.getSourceFrame(i));
+    }
+    return true;
+}
+
+void FrameStore::close()
+{
+    QMutexLocker locker(&mutex);
+    project.close();
+}
+
+QString FrameStore::getFileName() const
+{
+    return fileName;
+}
+
+int FrameStore::getFrameCount() const
+{
+    return frameCount;
+}
+
+int FrameStore::getSpriteSize() const
+{
+    return spriteSize;
+}
+
+QVector<QRgb> FrameStore::getPalette() const
+{
+    return palette;
+}
+
+int FrameStore::getSourceFrame(int index) const
+{
+    return sourceFrames.value(index, index);
+}
+
+QByteArray FrameStore::readRecord(int index)
+{
+    QMutexLocker locker(&mutex);
+    QByteArray record;
+    if (project.readRecordAt(index, record))
+    {
+        return record;
+    }
+
+    // A closed file is opened again, as long as it is still the file that was indexed
+    const QFileInfo info(fileName);
+    project.close();
+    if (info.lastModified() != modified || info.size() != fileSize || !project.openForRead()
+        || !project.indexRecords() || !project.readRecordAt(index, record))
+    {
+        qWarning() << "Could not read frame" << index << "of" << fileName;
+        return QByteArray();
+    }
+    return record;
+}
+
+QVector<Layer> FrameStore::decodeLayers(const QByteArray &record, const QHash<QRgb, QRgb> &recolor)
+{
+    QVector<Layer> layers = ProjectFile::decodeLayers(record);
+    for (Layer &layer : layers)
+    {
+        // Records decode to non-premultiplied pixels, the same form palette colors are kept in
+        if (!recolor.isEmpty())
+        {
+            for (int y = 0; y < layer.image.height(); ++y)
+            {
+                QRgb *row = reinterpret_cast<QRgb *>(layer.image.scanLine(y));
+                for (int x = 0; x < layer.image.width(); ++x)
+                {
+                    row[x] = recolor.value(row[x], row[x]);
+                }
+            }
+        }
+
+        // Painting and compositing both work on premultiplied pixels, as in Sprite::setLayers
+        layer.image = layer.image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        layer.occupied = TileSet::fromImage(layer.image);
+    }
+    return layers;
+}
+
+bool StoredFrame::isNull() const
+{
+    return record.isEmpty() && !store;
+}
+
+bool StoredFrame::recolor(const QVector<QRgb> &from, const QVector<QRgb> &to)
+{
+    // Later changes are still made from the colors the record was stored with, as its pixels never change
+    const QVector<QRgb> &stored = storedPalette.isEmpty() ? from : storedPalette;
+
+    QHash<QRgb, QRgb> changed;
+    for (int i = 0; i < stored.size(); ++i)
+    {
+        const QRgb color = i < to.size() ? to[i] : stored[i];
+        auto found = changed.constFind(stored[i]);
+        if (found != changed.constEnd() && found.value() != color)
+        {
+            return false;   // The pixels cannot tell which of the two entries they came from
+        }
+        changed.insert(stored[i], color);
+    }
+
+    storedPalette = stored;
+    palette = to;
+    return true;
+}
+
+QHash<QRgb, QRgb> StoredFrame::recolorTable() const
+{
+    QHash<QRgb, QRgb> changed;
+    for (int i = 0; i < storedPalette.size() && i < palette.size(); ++i)
+    {
+        if (palette[i] != storedPalette[i])
+        {
+            changed.insert(storedPalette[i], palette[i]);
+        }
+    }
+    return changed;
+}
+
+QByteArray StoredFrame::read() const
+{
+    const QByteArray encoded = store ? store->readRecord(index) : record;
+    if (storedPalette.isEmpty() || encoded.isEmpty())
+    {
+        return encoded;
+    }
+    return ProjectFile::encodeLayers(FrameStore::decodeLayers(encoded, recolorTable()));
+}
+
+QVector<Layer> StoredFrame::decode() const
+{
+    return FrameStore::decodeLayers(store ? store->readRecord(index) : record, recolorTable());
+}
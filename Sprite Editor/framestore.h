@@ -0,0 +1,165 @@
+/**
+ * Declaration of the FrameStore class and StoredFrame struct, which keep frames encoded until they are needed.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Golightly Chamberlain
+ */
+
+#ifndef FRAMESTORE_H
+#define FRAMESTORE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include "layer.h"
+#include "projectfile.h"
+
+/**
+ * The FrameStore class keeps a binary project open after it is loaded, so its frames can be read
+ * one at a time when they are first needed instead of all at once. Opening it only reads the
+ * header and the record index, however many frames the project holds. Records can be read from
+ * any thread.
+ */
+class FrameStore
+{
+public:
+
+    /**
+     * @brief Constructs a store for the given project. No file is opened yet.
+     * @param fileName The path of the .ssp project file.
+     */
+    explicit FrameStore(const QString &fileName);
+
+    /**
+     * @brief Opens the project and finds where each of its frame records starts.
+     * @return True if the project is a binary project whose records could all be found.
+     */
+    bool open();
+
+    /**
+     * @brief Closes the file, so it can be replaced. It is opened again by the next read, unless
+     * it was replaced in the meantime, in which case reads fail.
+     */
+    void close();
+
+    /**
+     * @brief Gets the path of the project.
+     */
+    QString getFileName() const;
+
+    /**
+     * @brief Gets the number of frames in the project.
+     */
+    int getFrameCount() const;
+
+    /**
+     * @brief Gets the side length of the frames in the project.
+     */
+    int getSpriteSize() const;
+
+    /**
+     * @brief Gets the palette of a project saved in indexed color mode.
+     * @return The non-premultiplied ARGB32 colors, or an empty vector if the project has no palette.
+     */
+    QVector<QRgb> getPalette() const;
+
+    /**
+     * @brief Gets the first frame of the project stored in the same record as a frame.
+     * @param index The position of the frame in the project.
+     * @return The frame itself, unless it was saved as a duplicate of an earlier frame.
+     */
+    int getSourceFrame(int index) const;
+
+    /**
+     * @brief Reads the encoded record of a frame.
+     * @param index The position of the frame in the project.
+     * @return The record, or an empty array if it could not be read.
+     */
+    QByteArray readRecord(int index);
+
+    /**
+     * @brief Decodes a frame record into layers ready for editing and compositing.
+     * @param record The encoded record.
+     * @param recolor Non-premultiplied colors to replace as the pixels are decoded, old color to new.
+     * @return Premultiplied layers with their painted tiles found, or no layers if the record is corrupt.
+     */
+    static QVector<Layer> decodeLayers(const QByteArray &record, const QHash<QRgb, QRgb> &recolor = {});
+
+private:
+
+    // Guards the file, which threads share.
+    QMutex mutex;
+
+    // The open project.
+    ProjectFile project;
+
+    // The path of the project.
+    QString fileName;
+
+    // The number of frames in the project.
+    int frameCount = 0;
+
+    // The side length of the frames in the project.
+    int spriteSize = 0;
+
+    // The palette of the project, empty if it has none.
+    QVector<QRgb> palette;
+
+    // The first frame stored in the same record as each frame.
+    QVector<int> sourceFrames;
+
+    // When the file was last modified and how big it was when indexed, to notice it being replaced.
+    QDateTime modified;
+    qint64 fileSize = 0;
+};
+
+/**
+ * The encoded pixels of a frame that is not loaded, either as a record held in memory or as a
+ * frame of a project file. A null StoredFrame holds neither.
+ */
+struct StoredFrame
+{
+    QByteArray record;                  ///< The record, if it is held in memory
+    QSharedPointer<FrameStore> store;   ///< The project holding the record otherwise
+    int index = -1;                     ///< The position of the frame in that project
+    QVector<QRgb> storedPalette;        ///< The palette when the record was stored, if it changed since
+    QVector<QRgb> palette;              ///< The palette now, whose colors replace those of storedPalette
+
+    /**
+     * @brief Returns whether the frame holds neither a record nor a place to read one from.
+     */
+    bool isNull() const;
+
+    /**
+     * @brief Notes a change of palette colors, to be made to the pixels whenever they are decoded, so
+     * the record is neither read nor decoded now.
+     * @param from The palette before the change, holding every color of the frame.
+     * @param to The palette after the change.
+     * @return True if the change was noted, false if the record has to be decoded to be recolored, as
+     * a color that changed is held by another palette entry that did not.
+     */
+    bool recolor(const QVector<QRgb> &from, const QVector<QRgb> &to);
+
+    /**
+     * @brief Gets the record, reading it from the project if it is not held in memory. A recolored
+     * frame is decoded and encoded again with its new colors.
+     */
+    QByteArray read() const;
+
+    /**
+     * @brief Decodes the frame with FrameStore::decodeLayers, in its current colors.
+     */
+    QVector<Layer> decode() const;
+
+private:
+
+    // The colors changed since the record was stored, old color to new.
+    QHash<QRgb, QRgb> recolorTable() const;
+};
+
+#endif // FRAMESTORE_H
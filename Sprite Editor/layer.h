@@ -0,0 +1,41 @@
+/**
+ * Declaration of the Layer struct, one stack of pixels within a frame.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Golightly Chamberlain
+ */
+
+#ifndef LAYER_H
+#define LAYER_H
+
+#include <QImage>
+#include <QString>
+#include "tileset.h"
+
+/**
+ * How the pixels of a layer combine with the layers below it.
+ */
+enum class BlendMode : quint8
+{
+    Normal,     ///< Paints over the layers below
+    Multiply,   ///< Darkens, white leaves the layers below unchanged
+    Screen,     ///< Lightens, black leaves the layers below unchanged
+    Add         ///< Adds the colors together, clamped to white
+};
+
+/**
+ * A layer of a frame. Every layer of a frame has the same size, and the visible layers are
+ * composited bottom to top to produce the image of the frame.
+ */
+struct Layer
+{
+    QImage image;                               ///< The pixels of the layer, premultiplied ARGB32
+    QString name;                               ///< The name shown in the layer list
+    bool visible = true;                        ///< Hidden layers are skipped when compositing
+    int opacity = 255;                          ///< 0 is invisible, 255 is fully opaque
+    BlendMode blendMode = BlendMode::Normal;    ///< How the layer combines with those below
+    TileSet occupied;                           ///< Tiles that may hold visible pixels, null if unknown
+};
+
+#endif // LAYER_H
@@ -6,12 +6,21 @@
  * @reviewer Pierce Jones
  */
 
+#include "batchprocessor.h"
 #include "startmenu.h"
 
 #include <QApplication>
+#include <QCoreApplication>
 
 int main(int argc, char *argv[])
 {
+    // A subcommand as the first argument runs a batch job without any windows
+    if (argc > 1 && BatchProcessor::isCommand(QString::fromLocal8Bit(argv[1])))
+    {
+        QCoreApplication app(argc, argv);
+        return BatchProcessor(app.arguments()).exec();
+    }
+
     QApplication a(argc, argv);
 
     StartMenu s;
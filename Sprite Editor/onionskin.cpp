@@ -0,0 +1,79 @@
+/**
+ * Implementation of the OnionSkin class, which blends the frames around the current one.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Golightly Chamberlain
+ */
+
+#include "onionskin.h"
+#include "compositor.h"
+
+OnionSkin::OnionSkin()
+{
+
+}
+
+void OnionSkin::setDepth(int frames)
+{
+    depth = qMax(0, frames);
+}
+
+int OnionSkin::getDepth() const
+{
+    return depth;
+}
+
+void OnionSkin::update(const QVector<Sprite *> &frames, int current)
+{
+    if (current < 0 || current >= frames.size())
+    {
+        return;
+    }
+
+    // Farther frames are listed first so nearer ones end up on top
+    QVector<Source> wanted;
+    for (int distance = depth; distance >= 1; --distance)
+    {
+        const int opacity = NearestOpacity * (depth - distance + 1) / depth;
+        for (int index : {current - distance, current + distance})
+        {
+            if (index >= 0 && index < frames.size())
+            {
+                wanted.append({frames[index], frames[index]->getVersion(), opacity});
+            }
+        }
+    }
+
+    const int size = frames[current]->getSpriteSize();
+    const bool sameSize = underlay.isNull() ? wanted.isEmpty() : underlay.width() == size;
+    if (wanted == sources && sameSize)
+    {
+        return;
+    }
+
+    sources = wanted;
+    if (wanted.isEmpty())
+    {
+        underlay = QImage();
+        return;
+    }
+
+    QVector<Layer> layers;
+    layers.reserve(wanted.size());
+    for (const Source &source : std::as_const(wanted))
+    {
+        Layer layer;
+        layer.image = source.frame->getImage();
+        layer.opacity = source.opacity;
+        layers.append(layer);
+    }
+
+    underlay = QImage(size, size, QImage::Format_ARGB32_Premultiplied);
+    Compositor::flatten(underlay, layers, underlay.rect());
+}
+
+const QImage &OnionSkin::getUnderlay() const
+{
+    return underlay;
+}
@@ -0,0 +1,88 @@
+/**
+ * Declaration of the OnionSkin class, which blends the frames around the current one.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Golightly Chamberlain
+ */
+
+#ifndef ONIONSKIN_H
+#define ONIONSKIN_H
+
+#include <QImage>
+#include <QVector>
+#include "sprite.h"
+
+/**
+ * The OnionSkin class composites the frames before and after the current frame into a single
+ * translucent underlay, nearer frames more opaque than farther ones. The underlay remembers
+ * which version of each neighbouring frame it was blended from and is only blended again once
+ * one of them changes, so drawing on the current frame never pays for its neighbours however
+ * many are shown.
+ */
+class OnionSkin
+{
+public:
+
+    /**
+     * The opacity of the nearest neighbouring frames, 0 to 255. Each frame farther away fades evenly
+     * towards transparent.
+     */
+    static const int NearestOpacity = 128;
+
+    /**
+     * @brief Constructs an onion skin that shows no neighbouring frames.
+     */
+    OnionSkin();
+
+    /**
+     * @brief Sets how many frames on each side of the current frame are shown.
+     * @param frames The number of frames before and after, 0 to show none.
+     */
+    void setDepth(int frames);
+
+    /**
+     * @brief Gets how many frames on each side of the current frame are shown.
+     */
+    int getDepth() const;
+
+    /**
+     * @brief Blends the neighbours of a frame again if any of them changed, or different
+     * frames became its neighbours, since the underlay was last blended.
+     * @param frames Every frame of the animation, in order.
+     * @param current The position of the frame being drawn on.
+     */
+    void update(const QVector<Sprite *> &frames, int current);
+
+    /**
+     * @brief Gets the blended neighbours, premultiplied ARGB32 the size of the current frame.
+     * @return The underlay, or a null image when no neighbours are shown.
+     */
+    const QImage &getUnderlay() const;
+
+private:
+
+    // A neighbouring frame as it was when the underlay was blended.
+    struct Source
+    {
+        const Sprite *frame;
+        quint64 version;
+        int opacity;
+
+        bool operator==(const Source &other) const
+        {
+            return frame == other.frame && version == other.version && opacity == other.opacity;
+        }
+    };
+
+    // The number of frames shown on each side.
+    int depth = 0;
+
+    // The frames the underlay was blended from, farthest first.
+    QVector<Source> sources;
+
+    // The blended neighbours.
+    QImage underlay;
+};
+
+#endif // ONIONSKIN_H
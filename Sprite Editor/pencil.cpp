@@ -7,6 +7,10 @@
  */
 
 #include "pencil.h"
+#include "pixelops.h"
+
+#include <algorithm>
+#include <cstdlib>
 
 Pencil::Pencil(int size, QColor color)
     : pencilSize(size)
@@ -48,11 +52,56 @@ QColor Pencil::getColor() const
 void Pencil::setToEraser()
 {
     isDrawing = false;
+    isFilling = false;
+    isSelecting = false;
 }
 
 void Pencil::setToPen()
 {
     isDrawing = true;
+    isFilling = false;
+    isSelecting = false;
+}
+
+void Pencil::setToBucket()
+{
+    isDrawing = true;
+    isFilling = true;
+    isSelecting = false;
+}
+
+void Pencil::setToSelect(bool lasso)
+{
+    isDrawing = true;
+    isFilling = false;
+    isSelecting = true;
+    isLasso = lasso;
+}
+
+void Pencil::setBrushShape(BrushShape shape)
+{
+    brushShape = shape;
+}
+
+BrushShape Pencil::getBrushShape() const
+{
+    return brushShape;
+}
+
+void Pencil::setCustomStamp(const QImage &image)
+{
+    customStamp = BrushStamp::fromImage(image);
+    stampSize = 0;
+}
+
+void Pencil::setMirrorMode(MirrorMode mode)
+{
+    mirrorMode = mode;
+}
+
+MirrorMode Pencil::getMirrorMode() const
+{
+    return mirrorMode;
 }
 
 bool Pencil::getMode()
@@ -60,7 +109,22 @@ bool Pencil::getMode()
     return isDrawing;
 }
 
-void Pencil::draw(float mouseX, float mouseY, QImage &canvas, int canvasDivisions)
+bool Pencil::getFillMode() const
+{
+    return isFilling;
+}
+
+bool Pencil::getSelectMode() const
+{
+    return isSelecting;
+}
+
+bool Pencil::getLassoMode() const
+{
+    return isLasso;
+}
+
+QRect Pencil::draw(float mouseX, float mouseY, QImage &canvas, int canvasDivisions)
 {
     if (isDrawing) {
         int pixelWidth = canvas.width() / canvasDivisions;
@@ -76,38 +140,230 @@ void Pencil::draw(float mouseX, float mouseY, QImage &canvas, int canvasDivision
         int startSquareX = middleX - (offset * pixelWidth);
         int startSquareY = middleY - (offset * pixelWidth);
 
-        QPainter painter(&canvas);
-        painter.setCompositionMode(QPainter::CompositionMode_Source);
-        painter.fillRect(startSquareX,
-                         startSquareY,
-                         pixelWidth * pencilSize,
-                         pixelWidth * pencilSize,
-                         pencilColor);
+        QRect square(startSquareX,
+                     startSquareY,
+                     pixelWidth * pencilSize,
+                     pixelWidth * pencilSize);
+
+        return PixelOps::fillRect(canvas, square, PixelOps::pixelFor(canvas, pencilColor.rgba()));
     }
+    return QRect();
 }
 
-void Pencil::erase(float mouseX, float mouseY, QImage &canvas, int canvasDivisions)
+QRect Pencil::stroke(const QVector<QPoint> &points, QImage &canvas,
+                     const std::function<void(const TileSet &)> &beforeWrite)
 {
-    if (!isDrawing) {
-        int pixelWidth = canvas.width() / canvasDivisions;
+    if (points.isEmpty())
+    {
+        return QRect();
+    }
 
-        int pixelX = mouseX / pixelWidth;
-        int pixelY = mouseY / pixelWidth;
+    const BrushStamp &brush = currentStamp();
+    QRgb color = isDrawing ? PixelOps::pixelFor(canvas, pencilColor.rgba()) : qRgba(0, 0, 0, 0);
 
-        int middleX = pixelX * pixelWidth;
-        int middleY = pixelY * pixelWidth;
+    // The mask only needs to cover the stroke, grown by the brush size
+    QRect bounds;
+    for (const QPoint &point : points)
+    {
+        bounds |= brush.footprint(point);
+    }
+    bounds = bounds.intersected(canvas.rect());
+    if (bounds.isEmpty() || brush.isEmpty())
+    {
+        return QRect();
+    }
 
-        int offset = (eraserSize - 1) / 2;
+    std::vector<uchar> mask(size_t(bounds.width()) * bounds.height(), 0);
 
-        int startSquareX = middleX - (offset * pixelWidth);
-        int startSquareY = middleY - (offset * pixelWidth);
+    // Bresenham between consecutive samples so no pixel along the way is skipped
+    brush.stampInto(points.first(), bounds, mask);
+    for (int i = 1; i < points.size(); ++i)
+    {
+        int x0 = points[i - 1].x();
+        int y0 = points[i - 1].y();
+        int x1 = points[i].x();
+        int y1 = points[i].y();
+        int dx = std::abs(x1 - x0);
+        int dy = -std::abs(y1 - y0);
+        int stepX = x0 < x1 ? 1 : -1;
+        int stepY = y0 < y1 ? 1 : -1;
+        int error = dx + dy;
+
+        while (x0 != x1 || y0 != y1)
+        {
+            int doubled = 2 * error;
+            if (doubled >= dy)
+            {
+                error += dy;
+                x0 += stepX;
+            }
+            if (doubled <= dx)
+            {
+                error += dx;
+                y0 += stepY;
+            }
+            brush.stampInto(QPoint(x0, y0), bounds, mask);
+        }
+    }
+
+    // Mirrored copies join the same mask, so the canvas is still written in a single pass
+    if (mirrorMode != MirrorMode::None)
+    {
+        mirror(canvas.rect(), bounds, mask);
+    }
+
+    if (beforeWrite)
+    {
+        // Only tiles the brush actually covers are reported, not the whole bounding box
+        TileSet touched(canvas.size());
+        const uchar *coverage = mask.data();
+        for (int y = bounds.top(); y <= bounds.bottom(); ++y)
+        {
+            int x = 0;
+            while (x < bounds.width())
+            {
+                if (!coverage[x])
+                {
+                    x++;
+                    continue;
+                }
+
+                // Skip the rest of this tile's columns once it is known to be covered
+                const int column = (bounds.left() + x) / TileSet::TileSize;
+                touched.insertTile(column, y / TileSet::TileSize);
+                x = (column + 1) * TileSet::TileSize - bounds.left();
+            }
+            coverage += bounds.width();
+        }
+        beforeWrite(touched);
+    }
+
+    // Apply the whole stroke in one pass over the covered rows
+    const uchar *coverage = mask.data();
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y)
+    {
+        QRgb *row = PixelOps::row(canvas, y) + bounds.left();
+        for (int x = 0; x < bounds.width(); ++x)
+        {
+            if (coverage[x])
+            {
+                row[x] = color;
+            }
+        }
+        coverage += bounds.width();
+    }
+
+    return bounds;
+}
 
-        QPainter painter(&canvas);
-        painter.setCompositionMode(QPainter::CompositionMode_Source);
-        painter.fillRect(startSquareX,
-                         startSquareY,
-                         pixelWidth * eraserSize,
-                         pixelWidth * eraserSize,
-                         QColor(0, 0, 0, 0));
+const BrushStamp &Pencil::currentStamp()
+{
+    const int size = getSize();
+    if (stampSize == size && stampShape == brushShape)
+    {
+        return stamp;
     }
+
+    switch (brushShape)
+    {
+    case BrushShape::Square:
+        stamp = BrushStamp::square(size);
+        break;
+    case BrushShape::Circle:
+        stamp = BrushStamp::circle(size);
+        break;
+    case BrushShape::Dither:
+        stamp = BrushStamp::dither(size);
+        break;
+    case BrushShape::Custom:
+        stamp = customStamp;
+        break;
+    }
+    stampShape = brushShape;
+    stampSize = size;
+    return stamp;
+}
+
+void Pencil::mirror(const QRect &canvas, QRect &bounds, std::vector<uchar> &mask) const
+{
+    // Each copy swaps the axes first if it is turned, then flips across the middle
+    struct Reflection
+    {
+        bool transpose;
+        bool flipX;
+        bool flipY;
+    };
+
+    QVector<Reflection> reflections;
+    switch (mirrorMode)
+    {
+    case MirrorMode::None:
+        return;
+    case MirrorMode::Horizontal:
+        reflections = {{false, true, false}};
+        break;
+    case MirrorMode::Vertical:
+        reflections = {{false, false, true}};
+        break;
+    case MirrorMode::Both:
+        reflections = {{false, true, false}, {false, false, true}, {false, true, true}};
+        break;
+    case MirrorMode::Radial:
+        if (canvas.width() != canvas.height())
+        {
+            return;
+        }
+        reflections = {{true, true, false}, {false, true, true}, {true, false, true}};
+        break;
+    }
+
+    auto reflect = [&canvas](const Reflection &reflection, QPoint point) {
+        if (reflection.transpose)
+        {
+            point = point.transposed();
+        }
+        if (reflection.flipX)
+        {
+            point.setX(canvas.right() - point.x());
+        }
+        if (reflection.flipY)
+        {
+            point.setY(canvas.bottom() - point.y());
+        }
+        return point;
+    };
+
+    QRect grown = bounds;
+    for (const Reflection &reflection : std::as_const(reflections))
+    {
+        const QPoint a = reflect(reflection, bounds.topLeft());
+        const QPoint b = reflect(reflection, bounds.bottomRight());
+        grown |= QRect(QPoint(std::min(a.x(), b.x()), std::min(a.y(), b.y())),
+                       QPoint(std::max(a.x(), b.x()), std::max(a.y(), b.y())));
+    }
+
+    std::vector<uchar> combined(size_t(grown.width()) * grown.height(), 0);
+    const uchar *coverage = mask.data();
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y)
+    {
+        // Copies may land on rows still to come, so the stroke itself is added rather than copied
+        uchar *row = combined.data() + size_t(y - grown.top()) * grown.width() + (bounds.left() - grown.left());
+        for (int x = 0; x < bounds.width(); ++x)
+        {
+            if (!coverage[x])
+            {
+                continue;
+            }
+            row[x] = 1;
+            for (const Reflection &reflection : std::as_const(reflections))
+            {
+                const QPoint point = reflect(reflection, QPoint(bounds.left() + x, y));
+                combined[size_t(point.y() - grown.top()) * grown.width() + (point.x() - grown.left())] = 1;
+            }
+        }
+        coverage += bounds.width();
+    }
+
+    bounds = grown;
+    mask.swap(combined);
 }
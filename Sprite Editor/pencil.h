@@ -12,6 +12,34 @@
 #include <QColor>
 #include <QImage>
 #include <QPainter>
+#include <QVector>
+#include <functional>
+#include <vector>
+#include "brushstamp.h"
+#include "tileset.h"
+
+/**
+ * The shape the pencil and eraser leave at each point of a stroke.
+ */
+enum class BrushShape
+{
+    Square,     ///< A solid square
+    Circle,     ///< A solid circle
+    Dither,     ///< A circle that paints every other pixel in a checkerboard
+    Custom      ///< The shape of an image given to Pencil::setCustomStamp
+};
+
+/**
+ * The copies of each stroke that are drawn reflected across the middle of the canvas.
+ */
+enum class MirrorMode
+{
+    None,       ///< Only the stroke itself
+    Horizontal, ///< Mirrored left to right
+    Vertical,   ///< Mirrored top to bottom
+    Both,       ///< Mirrored left to right, top to bottom and both at once
+    Radial      ///< Turned a quarter, half and three quarters around the middle
+};
 
 /**
  * The Pencil class captures the basic attributes of a pencil,
@@ -55,24 +83,62 @@ public:
     int getSize() const;
 
     /**
-     * @brief Draws at the specified location on the provided canvas.
+     * @brief Draws a square of the pencil size at the specified location on the provided canvas,
+     *        ignoring the brush shape and mirror mode. The editor draws with stroke instead, this
+     *        legacy entry point is only kept as the baseline for the pencilDraw benchmark row.
      * @param mouseX The X coordinate where drawing should occur.
      * @param mouseY The Y coordinate where drawing should occur.
      * @param canvas The QImage on which drawing takes place.
      * @param canvasDivisions A division factor (for scaling or offset)
      *        applied to the mouse coordinates.
+     * @return The rectangle of canvas pixels that were changed.
      */
-    void draw(float mouseX, float mouseY, QImage& canvas, int canvasDivisions);
+    QRect draw(float mouseX, float mouseY, QImage& canvas, int canvasDivisions);
 
     /**
-     * @brief Erases at the specified location on the provided canvas.
-     * @param mouseX The X coordinate where erasing should occur.
-     * @param mouseY The Y coordinate where erasing should occur.
-     * @param canvas The QImage on which erasing takes place.
-     * @param canvasDivisions A division factor (for scaling or offset)
-     *        applied to the mouse coordinates.
+     * @brief Sets the shape of the pencil and eraser.
+     * @param shape The new brush shape.
      */
-    void erase(float mouseX, float mouseY, QImage& canvas, int canvasDivisions);
+    void setBrushShape(BrushShape shape);
+
+    /**
+     * @brief Retrieves the shape of the pencil and eraser.
+     * @return The current brush shape.
+     */
+    BrushShape getBrushShape() const;
+
+    /**
+     * @brief Sets the shape used by BrushShape::Custom, which ignores the brush sizes.
+     * @param image The image whose pixels that are not fully transparent form the brush.
+     */
+    void setCustomStamp(const QImage &image);
+
+    /**
+     * @brief Sets which mirrored copies of each stroke are drawn. Radial mirroring needs a
+     *        square canvas and draws only the stroke itself on any other.
+     * @param mode The new mirror mode.
+     */
+    void setMirrorMode(MirrorMode mode);
+
+    /**
+     * @brief Retrieves which mirrored copies of each stroke are drawn.
+     * @return The current mirror mode.
+     */
+    MirrorMode getMirrorMode() const;
+
+    /**
+     * @brief Draws or erases, depending on the current mode, along a connected series of
+     *        canvas pixels. Every segment is rasterized so fast strokes leave no gaps, the
+     *        brush stamp is copied into a coverage mask along with its mirrored copies,
+     *        and the canvas is then written in a single pass over the covered rows.
+     * @param points The pixel positions of the stroke, in order.
+     * @param canvas The ARGB32 or premultiplied ARGB32 QImage on which the stroke takes place.
+     * @param beforeWrite If set, called with the tiles the brush covers just before the
+     *        canvas is written, so the caller can save their pixels for undo.
+     * @return The rectangle of canvas pixels that were changed.
+     */
+    QRect stroke(const QVector<QPoint> &points, QImage &canvas,
+                 const std::function<void(const TileSet &)> &beforeWrite = nullptr);
 
     /**
      * @brief Sets the tool mode to pen (drawing).
@@ -84,12 +150,41 @@ public:
      */
     void setToEraser();
 
+    /**
+     * @brief Sets the tool mode to bucket fill.
+     */
+    void setToBucket();
+
+    /**
+     * @brief Sets the tool mode to selection.
+     * @param lasso True to select freehand shapes, false to select rectangles.
+     */
+    void setToSelect(bool lasso);
+
     /**
      * @brief Retrieves the current mode of the pencil.
      * @return True if in drawing mode, false if in eraser mode.
      */
     bool getMode();
 
+    /**
+     * @brief Retrieves whether the pencil is in bucket fill mode.
+     * @return True if clicks should fill regions instead of drawing.
+     */
+    bool getFillMode() const;
+
+    /**
+     * @brief Retrieves whether the pencil is in selection mode.
+     * @return True if clicks should select or move pixels instead of drawing.
+     */
+    bool getSelectMode() const;
+
+    /**
+     * @brief Retrieves whether selections are freehand.
+     * @return True for lasso selection, false for rectangles.
+     */
+    bool getLassoMode() const;
+
     /**
      * @brief Retrieves the current color of the pencil.
      * @return The QColor representing the pencil’s color.
@@ -97,10 +192,33 @@ public:
     QColor getColor() const;
 
 private:
+
+    /**
+     * @brief Gets the stamp of the active tool, making it again if the shape or size changed.
+     */
+    const BrushStamp &currentStamp();
+
+    /**
+     * @brief Adds the mirrored copies of a stroke mask to it, growing it to cover them.
+     * @param canvas The rectangle of the canvas, whose middle the copies are mirrored across.
+     * @param bounds The canvas area the mask covers, updated to the area of the grown mask.
+     * @param mask One byte per pixel of bounds, set to 1 where the brush has been.
+     */
+    void mirror(const QRect &canvas, QRect &bounds, std::vector<uchar> &mask) const;
+
     int pencilSize;        /// Size of the pencil tip in drawing mode
     int eraserSize;        /// Size of the eraser in eraser mode
     bool isDrawing = true; /// True if the pencil is in drawing mode, false if erasing
+    bool isFilling = false; /// True if the pencil is in bucket fill mode
+    bool isSelecting = false; /// True if the pencil is in selection mode
+    bool isLasso = false;  /// True if selections are freehand rather than rectangles
     QColor pencilColor;    /// Current color of the pencil
+    BrushShape brushShape = BrushShape::Square; /// Shape of the pencil and eraser
+    MirrorMode mirrorMode = MirrorMode::None;   /// Mirrored copies drawn with each stroke
+    BrushStamp customStamp; /// Shape used by BrushShape::Custom
+    BrushStamp stamp;      /// Stamp of the last shape and size a stroke used
+    BrushShape stampShape = BrushShape::Square; /// Shape the stamp was made for
+    int stampSize = 0;     /// Size the stamp was made for, 0 before the first stroke
 };
 
 #endif
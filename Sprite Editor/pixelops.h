@@ -0,0 +1,506 @@
+/**
+ * Bulk pixel operations that work directly on the scanlines of 32-bit QImages.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Pierce Jones
+ */
+
+#ifndef PIXELOPS_H
+#define PIXELOPS_H
+
+#include <QImage>
+#include <QRect>
+#include <QRgb>
+#include <QtAlgorithms>
+#include <QVector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * The PixelOps functions read and write whole rows of a 32 bits per pixel image at once,
+ * avoiding the QColor construction and format dispatch of QImage::pixelColor/setPixelColor.
+ * Every function clips to the bounds of the image.
+ */
+namespace PixelOps
+{
+
+/**
+ * @brief row Gets a writable row of pixels.
+ * @param image The 32-bit image to access.
+ * @param y The row to get.
+ * @return A pointer to the first pixel of the row.
+ */
+inline QRgb *row(QImage &image, int y)
+{
+    Q_ASSERT(image.depth() == 32);
+    return reinterpret_cast<QRgb *>(image.scanLine(y));
+}
+
+/**
+ * @brief constRow Gets a read-only row of pixels without detaching the image.
+ * @param image The 32-bit image to access.
+ * @param y The row to get.
+ * @return A pointer to the first pixel of the row.
+ */
+inline const QRgb *constRow(const QImage &image, int y)
+{
+    Q_ASSERT(image.depth() == 32);
+    return reinterpret_cast<const QRgb *>(image.constScanLine(y));
+}
+
+/**
+ * @brief blankImage Makes a fully transparent 32-bit image backed by zeroed memory from calloc.
+ * Large allocations are mapped lazily by the system, so rows that are never written do not take
+ * up physical memory, which keeps mostly empty large canvases cheap.
+ * @param size The size of the image.
+ * @param format A 32-bit format in which all-zero pixels are transparent.
+ * @return The new image, or a null image if the memory could not be allocated.
+ */
+inline QImage blankImage(const QSize &size, QImage::Format format)
+{
+    const qsizetype bytesPerLine = qsizetype(size.width()) * 4;
+    void *data = std::calloc(size_t(bytesPerLine) * size_t(size.height()), 1);
+    if (!data)
+    {
+        return QImage();
+    }
+    return QImage(static_cast<uchar *>(data), size.width(), size.height(), bytesPerLine, format,
+                  [](void *info) { std::free(info); }, data);
+}
+
+/**
+ * @brief pixelFor Converts a color to the pixel value it is stored as in an image, premultiplying
+ * it for premultiplied images.
+ * @param image The 32-bit image the color is written to.
+ * @param color The non-premultiplied ARGB color.
+ * @return The color in the pixel format of the image.
+ */
+inline QRgb pixelFor(const QImage &image, QRgb color)
+{
+    return image.format() == QImage::Format_ARGB32_Premultiplied ? qPremultiply(color) : color;
+}
+
+/**
+ * @brief colorOf Converts a pixel of an image back to a non-premultiplied ARGB color.
+ * @param image The 32-bit image the pixel was read from.
+ * @param pixel The pixel value.
+ * @return The non-premultiplied ARGB color.
+ */
+inline QRgb colorOf(const QImage &image, QRgb pixel)
+{
+    return image.format() == QImage::Format_ARGB32_Premultiplied ? qUnpremultiply(pixel) : pixel;
+}
+
+/**
+ * @brief fillRect Sets every pixel inside a rectangle to one color.
+ * @param image The 32-bit image to write.
+ * @param rect The rectangle to fill.
+ * @param color The color to write, already in the pixel format of the image.
+ * @return The part of the rectangle that lay inside the image.
+ */
+inline QRect fillRect(QImage &image, const QRect &rect, QRgb color)
+{
+    const QRect clipped = rect.intersected(image.rect());
+    for (int y = clipped.top(); y <= clipped.bottom(); ++y)
+    {
+        std::fill_n(row(image, y) + clipped.left(), clipped.width(), color);
+    }
+    return clipped;
+}
+
+/**
+ * @brief blit Copies the pixels of one image into another, replacing what was there.
+ * @param dest The 32-bit image to write.
+ * @param source The 32-bit image to copy from.
+ * @param topLeft Where the top left pixel of source lands in dest.
+ * @return The rectangle of dest that was written.
+ */
+inline QRect blit(QImage &dest, const QImage &source, const QPoint &topLeft)
+{
+    const QRect target = QRect(topLeft, source.size()).intersected(dest.rect());
+    const int sourceX = target.left() - topLeft.x();
+    for (int y = target.top(); y <= target.bottom(); ++y)
+    {
+        std::memcpy(row(dest, y) + target.left(),
+                    constRow(source, y - topLeft.y()) + sourceX,
+                    size_t(target.width()) * sizeof(QRgb));
+    }
+    return target;
+}
+
+/**
+ * @brief floodFill Fills the 4-connected region of same-colored pixels around a start pixel.
+ * Works a horizontal span at a time: each seed is widened to the full run of matching pixels
+ * in its row, the run is filled, and one new seed is queued per matching run above and below.
+ * @param image The 32-bit image to write.
+ * @param start The pixel the fill starts from.
+ * @param color The color to fill with.
+ * @param beforeWrite If set, called with each span just before it is filled.
+ * @return The bounding rectangle of the pixels that changed.
+ */
+inline QRect floodFill(QImage &image, const QPoint &start, QRgb color,
+                       const std::function<void(const QRect &)> &beforeWrite = {})
+{
+    if (!image.rect().contains(start))
+    {
+        return QRect();
+    }
+
+    const QRgb target = constRow(image, start.y())[start.x()];
+    if (target == color)
+    {
+        return QRect();
+    }
+
+    const int width = image.width();
+    const int height = image.height();
+    QRect filled;
+    QVector<QPoint> seeds{start};
+
+    while (!seeds.isEmpty())
+    {
+        const QPoint seed = seeds.takeLast();
+        QRgb *line = row(image, seed.y());
+        if (line[seed.x()] != target)
+        {
+            continue;   // Already filled through another span
+        }
+
+        int left = seed.x();
+        while (left > 0 && line[left - 1] == target)
+        {
+            --left;
+        }
+        int right = seed.x();
+        while (right < width - 1 && line[right + 1] == target)
+        {
+            ++right;
+        }
+
+        const QRect span(left, seed.y(), right - left + 1, 1);
+        if (beforeWrite)
+        {
+            beforeWrite(span);
+        }
+        std::fill(line + left, line + right + 1, color);
+        filled |= span;
+
+        for (int y : {seed.y() - 1, seed.y() + 1})
+        {
+            if (y < 0 || y >= height)
+            {
+                continue;
+            }
+
+            const QRgb *adjacent = constRow(image, y);
+            bool inRun = false;
+            for (int x = left; x <= right; ++x)
+            {
+                bool matches = adjacent[x] == target;
+                if (matches && !inRun)
+                {
+                    seeds.append(QPoint(x, y));
+                }
+                inRun = matches;
+            }
+        }
+    }
+
+    return filled;
+}
+
+/**
+ * @brief replaceColor Replaces every pixel of one exact color with another. Four pixels are
+ * compared at a time with SSE2 where available, with a scalar loop for the remainder.
+ * @param image The 32-bit image to write.
+ * @param from The color to replace.
+ * @param to The color to write in its place.
+ * @param beforeWrite If set, called with the pixels about to be replaced just before they are written.
+ * @return The bounding rectangle of the pixels that changed.
+ */
+inline QRect replaceColor(QImage &image, QRgb from, QRgb to,
+                          const std::function<void(const QRect &)> &beforeWrite = {})
+{
+    int minX = image.width();
+    int maxX = -1;
+    int minY = image.height();
+    int maxY = -1;
+
+#if defined(__SSE2__)
+    const __m128i fromColor = _mm_set1_epi32(int(from));
+    const __m128i toColor = _mm_set1_epi32(int(to));
+#endif
+
+    for (int y = 0; y < image.height(); ++y)
+    {
+        QRgb *line = row(image, y);
+        int rowMin = image.width();
+        int rowMax = -1;
+        int x = 0;
+
+#if defined(__SSE2__)
+        for (; x + 4 <= image.width(); x += 4)
+        {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(line + x));
+            __m128i hit = _mm_cmpeq_epi32(pixels, fromColor);
+            quint32 bits = quint32(_mm_movemask_epi8(hit));   // 4 bits per matching pixel
+            if (bits)
+            {
+                if (beforeWrite)
+                {
+                    beforeWrite(QRect(x, y, 4, 1));
+                }
+                __m128i blended = _mm_or_si128(_mm_andnot_si128(hit, pixels), _mm_and_si128(hit, toColor));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(line + x), blended);
+                rowMin = qMin(rowMin, x + int(qCountTrailingZeroBits(bits)) / 4);
+                rowMax = qMax(rowMax, x + (31 - int(qCountLeadingZeroBits(bits))) / 4);
+            }
+        }
+#endif
+
+        for (; x < image.width(); ++x)
+        {
+            if (line[x] == from)
+            {
+                if (beforeWrite)
+                {
+                    beforeWrite(QRect(x, y, 1, 1));
+                }
+                line[x] = to;
+                rowMin = qMin(rowMin, x);
+                rowMax = qMax(rowMax, x);
+            }
+        }
+
+        if (rowMax >= 0)
+        {
+            minX = qMin(minX, rowMin);
+            maxX = qMax(maxX, rowMax);
+            minY = qMin(minY, y);
+            maxY = y;
+        }
+    }
+
+    return maxY < 0 ? QRect() : QRect(QPoint(minX, minY), QPoint(maxX, maxY));
+}
+
+
+/**
+ * @brief blitMasked Copies the pixels of one image into another where a mask is set. Fully
+ * transparent source pixels are skipped, so what lies underneath shows through them.
+ * @param dest The 32-bit image to write.
+ * @param source The 32-bit image to copy from.
+ * @param mask An 8-bit image the size of source, nonzero where pixels are copied, or a null
+ * image to copy every pixel.
+ * @param topLeft Where the top left pixel of source lands in dest.
+ * @return The rectangle of dest that was written.
+ */
+inline QRect blitMasked(QImage &dest, const QImage &source, const QImage &mask, const QPoint &topLeft)
+{
+    const QRect target = QRect(topLeft, source.size()).intersected(dest.rect());
+    for (int y = target.top(); y <= target.bottom(); ++y)
+    {
+        QRgb *out = row(dest, y);
+        const QRgb *in = constRow(source, y - topLeft.y()) - topLeft.x();
+        const uchar *selected = mask.isNull() ? nullptr : mask.constScanLine(y - topLeft.y()) - topLeft.x();
+        for (int x = target.left(); x <= target.right(); ++x)
+        {
+            if (in[x] != 0 && (!selected || selected[x]))
+            {
+                out[x] = in[x];
+            }
+        }
+    }
+    return target;
+}
+
+/**
+ * @brief clearMasked Makes the pixels inside a rectangle transparent where a mask is set.
+ * @param image The 32-bit image to write.
+ * @param rect The rectangle to clear.
+ * @param mask An 8-bit image the size of rect, nonzero where pixels are cleared, or a null
+ * image to clear the whole rectangle.
+ * @return The part of the rectangle that lay inside the image.
+ */
+inline QRect clearMasked(QImage &image, const QRect &rect, const QImage &mask)
+{
+    if (mask.isNull())
+    {
+        return fillRect(image, rect, 0);
+    }
+
+    const QRect clipped = rect.intersected(image.rect());
+    for (int y = clipped.top(); y <= clipped.bottom(); ++y)
+    {
+        QRgb *out = row(image, y);
+        const uchar *selected = mask.constScanLine(y - rect.top()) - rect.left();
+        for (int x = clipped.left(); x <= clipped.right(); ++x)
+        {
+            if (selected[x])
+            {
+                out[x] = 0;
+            }
+        }
+    }
+    return clipped;
+}
+
+/**
+ * @brief flipVertical Mirrors an 8 or 32-bit image top to bottom by swapping whole rows.
+ * @param image The image to flip in place.
+ */
+inline void flipVertical(QImage &image)
+{
+    const qsizetype rowBytes = qsizetype(image.width()) * image.depth() / 8;
+    for (int top = 0, bottom = image.height() - 1; top < bottom; ++top, --bottom)
+    {
+        std::swap_ranges(image.scanLine(top), image.scanLine(top) + rowBytes, image.scanLine(bottom));
+    }
+}
+
+/**
+ * @brief flipHorizontal Mirrors an 8 or 32-bit image left to right, one row at a time.
+ * @param image The image to flip in place.
+ */
+inline void flipHorizontal(QImage &image)
+{
+    for (int y = 0; y < image.height(); ++y)
+    {
+        if (image.depth() == 32)
+        {
+            std::reverse(row(image, y), row(image, y) + image.width());
+        }
+        else
+        {
+            std::reverse(image.scanLine(y), image.scanLine(y) + image.width());
+        }
+    }
+}
+
+/**
+ * @brief transposeInto Copies source into dest with rows and columns swapped. The image is
+ * walked in square blocks, so the few dozen rows of dest written by a block stay in cache
+ * instead of every pixel read landing in a different cache line.
+ * @param source The image to read.
+ * @param dest An image of the same format with the width and height of source swapped.
+ */
+template <typename Pixel>
+inline void transposeInto(const QImage &source, QImage &dest)
+{
+    const int BlockSize = 32;
+    const int width = source.width();
+    const int height = source.height();
+    uchar *destBits = dest.bits();
+    const qsizetype destStride = dest.bytesPerLine();
+
+    for (int blockY = 0; blockY < height; blockY += BlockSize)
+    {
+        const int endY = qMin(height, blockY + BlockSize);
+        for (int blockX = 0; blockX < width; blockX += BlockSize)
+        {
+            const int endX = qMin(width, blockX + BlockSize);
+            for (int y = blockY; y < endY; ++y)
+            {
+                const Pixel *in = reinterpret_cast<const Pixel *>(source.constScanLine(y));
+                for (int x = blockX; x < endX; ++x)
+                {
+                    reinterpret_cast<Pixel *>(destBits + x * destStride)[y] = in[x];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief rotated90 Rotates an 8 or 32-bit image by a quarter turn, as a blocked transpose
+ * followed by a flip.
+ * @param image The image to rotate.
+ * @param clockwise True to turn clockwise, false to turn counterclockwise.
+ * @return The rotated image, with width and height swapped.
+ */
+inline QImage rotated90(const QImage &image, bool clockwise)
+{
+    QImage result(image.height(), image.width(), image.format());
+    if (image.depth() == 32)
+    {
+        transposeInto<quint32>(image, result);
+    }
+    else
+    {
+        transposeInto<uchar>(image, result);
+    }
+
+    if (clockwise)
+    {
+        flipHorizontal(result);
+    }
+    else
+    {
+        flipVertical(result);
+    }
+    return result;
+}
+
+/**
+ * @brief scaledNearestAs Implements scaledNearest for one pixel size.
+ */
+template <typename Pixel>
+inline QImage scaledNearestAs(const QImage &image, const QSize &size)
+{
+    QImage result(size, image.format());
+    std::vector<int> sourceX(size.width());
+    for (int x = 0; x < size.width(); ++x)
+    {
+        sourceX[x] = int(qint64(x) * image.width() / size.width());
+    }
+
+    const qsizetype rowBytes = qsizetype(size.width()) * sizeof(Pixel);
+    int lastY = -1;
+    for (int y = 0; y < size.height(); ++y)
+    {
+        const int sourceY = int(qint64(y) * image.height() / size.height());
+        Pixel *out = reinterpret_cast<Pixel *>(result.scanLine(y));
+        if (sourceY == lastY)
+        {
+            std::memcpy(out, result.constScanLine(y - 1), size_t(rowBytes));
+            continue;
+        }
+
+        const Pixel *in = reinterpret_cast<const Pixel *>(image.constScanLine(sourceY));
+        for (int x = 0; x < size.width(); ++x)
+        {
+            out[x] = in[sourceX[x]];
+        }
+        lastY = sourceY;
+    }
+    return result;
+}
+
+/**
+ * @brief scaledNearest Resizes an 8 or 32-bit image with nearest neighbour sampling. Source
+ * columns are looked up once per image, and output rows that sample the same source row are
+ * copied from the row above rather than sampled again.
+ * @param image The image to scale.
+ * @param size The size of the result.
+ * @return The scaled image.
+ */
+inline QImage scaledNearest(const QImage &image, const QSize &size)
+{
+    if (image.isNull() || size.isEmpty())
+    {
+        return QImage();
+    }
+    return image.depth() == 32 ? scaledNearestAs<quint32>(image, size) : scaledNearestAs<uchar>(image, size);
+}
+
+}
+
+#endif // PIXELOPS_H
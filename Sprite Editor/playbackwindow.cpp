@@ -18,26 +18,27 @@ PlaybackWindow::PlaybackWindow(const QVector<Sprite*>& frames, int fps, QWidget
     setAutoFillBackground(true);
     if (!frames.isEmpty())
     {
-        QImage img = frames[0]->getImage();
-        currentFrame = img;
+        currentFrame = frameCache.pixmap(frames[0]);
     }
 
-    // timer to control FPS
-    timer = new QTimer(this);
-    connect(timer,
-            &QTimer::timeout,
+    // scheduler to control FPS
+    scheduler = new FrameScheduler(this);
+    scheduler->setFps(fps);
+    scheduler->setFrameCount(frames.size());
+    connect(scheduler,
+            &FrameScheduler::frameChanged,
             this,
             &PlaybackWindow::updateFrame);
-    timer->start(1000 / fps);
+    scheduler->start();
 }
 
-void PlaybackWindow::updateFrame()
+void PlaybackWindow::updateFrame(int frameIndex)
 {
     if (frames.isEmpty()) return;
 
-    currentFrame = frames[currentIndex]->getImage();
+    currentIndex = frameIndex;
+    currentFrame = frameCache.pixmap(frames[currentIndex]);   // only converts frames edited since last shown
     update();  // triggers paintEvent
-    currentIndex = (currentIndex + 1) % frames.size();
 }
 
 
@@ -51,7 +52,7 @@ void PlaybackWindow::paintEvent(QPaintEvent *event)
     {
         int x = (width() - currentFrame.width()) / 2;
         int y = (height() - currentFrame.height()) / 2;
-        painter.drawImage(x, y, currentFrame);
+        painter.drawPixmap(x, y, currentFrame);
     }
 
-}
+}
\ No newline at end of file
@@ -13,14 +13,15 @@
 
 #include <QWidget>
 #include <QImage>
-#include <QTimer>
+#include "framecache.h"
+#include "framescheduler.h"
 #include "sprite.h"
 #include <QPainter>
 
 /**
  * The PlaybackWindow class dispalys a sequence of animation frames.
  * The sprite is in actual pixel size in a new window.
- *  A timer that follows the current framerate controls playback speed.
+ *  A scheduler that follows the current framerate controls playback speed.
  */
 class PlaybackWindow : public QWidget
 {
@@ -47,17 +48,18 @@ protected:
 private slots:
 
     /**
-     *  @brief updateFrame Advances to the next animation frame and triggers a repaint.
+     *  @brief updateFrame Shows the frame chosen by the scheduler and triggers a repaint.
+     *  @param frameIndex The frame to show.
      */
-    void updateFrame();
+    void updateFrame(int frameIndex);
 
 private:
 
     QVector<Sprite *> frames;   /// Vector of frames to animate
-    QImage frame;               /// Image used for rendering
+    FrameCache frameCache;      /// Native pixmaps of the frames, converted once per edit
     int currentIndex;           /// Index of the currently displayed frame
-    QImage currentFrame;        /// The current frame being shown
-    QTimer *timer;              /// Timer controlling the playback speed
+    QPixmap currentFrame;       /// The current frame being shown
+    FrameScheduler *scheduler;  /// Scheduler controlling the playback speed
 };
 
 #endif // PLAYBACKWINDOW_H
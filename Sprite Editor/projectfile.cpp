@@ -0,0 +1,875 @@
+/**
+ * Implementation of the ProjectFile class, which reads and writes .ssp project files.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer John Gibb
+ */
+
+#include "projectfile.h"
+#include "compositor.h"
+#include "pixelops.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QJsonDocument>
+#include <QtEndian>
+#include <algorithm>
+
+namespace
+{
+// The first bytes of every binary project.
+const QByteArray FileMagic("SSPB");
+
+// The newest version of the binary container this build can read and write.
+const quint16 FormatVersion = 6;
+
+// The first version whose files end with an index of their records.
+const quint16 IndexedVersion = 5;
+
+// The first version whose frames can refer to an identical earlier frame instead of repeating its record.
+const quint16 SharedRecordVersion = 6;
+
+// The last bytes of a file with a record index, after the offset of the index.
+const QByteArray IndexMagic("SSPX");
+
+// Set in the header flags when the project palette follows the header.
+const quint16 HasPaletteFlag = 0x1;
+
+// Byte offset of the frame count within the header.
+const qint64 FrameCountOffset = 12;
+
+// Size of the uncompressed encoding, width and height fields of a frame record.
+const int RecordHeaderSize = 9;
+
+// Size of a record that refers to an earlier frame: its encoding and the position of that frame.
+const int ReferenceRecordSize = 5;
+
+// Frames with more colors than this are stored as raw ARGB rows.
+const int MaxPaletteSize = 256;
+
+// Frames with more layers than this are rejected as corrupt.
+const int MaxLayerCount = 256;
+}
+
+ProjectFile::ProjectFile(const QString &fileName)
+    : fileName(fileName)
+{
+
+}
+
+bool ProjectFile::openForRead()
+{
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    isWriting = false;
+    nextFrame = 0;
+
+    if (file.peek(FileMagic.size()) != FileMagic)
+    {
+        QByteArray data = file.readAll();    // Anything else is treated as a legacy JSON project
+        file.close();
+        return openJson(data);
+    }
+
+    isJson = false;
+    stream.setDevice(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.skipRawData(FileMagic.size());
+
+    quint16 version;
+    quint16 flags;
+    quint32 size;
+    quint32 count;
+    stream >> version >> flags >> size >> count;
+
+    if (stream.status() != QDataStream::Ok || version == 0 || version > FormatVersion)
+    {
+        qWarning() << "Unsupported project version in" << fileName;
+        close();
+        return false;
+    }
+
+    spriteSize = int(size);
+    frameCount = int(count);
+    formatVersion = version;
+    recordOffsets.clear();
+    sourceFrames.clear();
+
+    palette.clear();
+    if (flags & HasPaletteFlag)
+    {
+        quint16 paletteSize;
+        stream >> paletteSize;
+        for (int i = 0; i < paletteSize && stream.status() == QDataStream::Ok; ++i)
+        {
+            quint32 color;
+            stream >> color;
+            palette.append(color);
+        }
+
+        if (stream.status() != QDataStream::Ok || palette.size() > MaxPaletteSize)
+        {
+            qWarning() << "Corrupt palette in" << fileName;
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ProjectFile::openForWrite(int spriteSize, int frameCount, const QVector<QRgb> &palette)
+{
+    saveFile.setFileName(fileName);
+    if (!saveFile.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    isJson = false;
+    isWriting = true;
+    nextFrame = 0;
+    recordOffsets.clear();
+    sourceFrames.clear();
+    this->spriteSize = spriteSize;
+    this->frameCount = frameCount;
+    this->palette = palette.mid(0, MaxPaletteSize);
+
+    stream.setDevice(&saveFile);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData(FileMagic.constData(), FileMagic.size());
+    stream << FormatVersion
+           << quint16(this->palette.isEmpty() ? 0 : HasPaletteFlag)
+           << quint32(spriteSize)
+           << quint32(frameCount);
+
+    if (!this->palette.isEmpty())
+    {
+        stream << quint16(this->palette.size());
+        for (QRgb color : std::as_const(this->palette))
+        {
+            stream << quint32(color);
+        }
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool ProjectFile::readFrame(QImage &frame)
+{
+    while (nextFrame < frameCount)
+    {
+        int index = nextFrame;
+        if (isJson)
+        {
+            frame = decodeJsonFrame(jsonFrames[index].toObject());
+            nextFrame++;
+        }
+        else
+        {
+            QByteArray record;
+            if (!readRecord(record))
+            {
+                return false;
+            }
+            frame = decodeFrame(record);
+        }
+
+        if (!frame.isNull())
+        {
+            return true;
+        }
+        qWarning() << "Frame" << index << "could not be decoded";
+    }
+    return false;
+}
+
+bool ProjectFile::readRecord(QByteArray &record)
+{
+    if (isJson || isWriting || nextFrame >= frameCount)
+    {
+        return false;
+    }
+
+    const qint64 offset = file.pos();
+    stream >> record;
+    if (stream.status() != QDataStream::Ok)
+    {
+        qWarning() << "Project" << fileName << "is truncated at frame" << nextFrame;
+        return false;
+    }
+
+    // A frame stored as a reference is read from the record of the frame it repeats
+    const int source = referencedFrame(record);
+    if (source >= 0)
+    {
+        const qint64 resume = file.pos();
+        if (source >= nextFrame || source >= recordOffsets.size() || !readRecordAt(source, record)
+            || !file.seek(resume))
+        {
+            qWarning() << "Frame" << nextFrame << "of" << fileName << "refers to a frame that cannot be read";
+            return false;
+        }
+    }
+
+    // Offsets are noted as records go by, so later references can find them
+    if (recordOffsets.size() == nextFrame)
+    {
+        recordOffsets.append(source >= 0 ? recordOffsets[source] : offset);
+        sourceFrames.append(source >= 0 ? sourceFrames[source] : nextFrame);
+    }
+    nextFrame++;
+    return true;
+}
+
+bool ProjectFile::writeFrame(const QImage &frame)
+{
+    return writeRecord(encodeFrame(frame));
+}
+
+bool ProjectFile::writeRecord(const QByteArray &record)
+{
+    if (!isWriting)
+    {
+        return false;
+    }
+
+    recordOffsets.append(saveFile.pos());
+    sourceFrames.append(nextFrame);
+    stream << record;
+    nextFrame++;
+    return stream.status() == QDataStream::Ok;
+}
+
+bool ProjectFile::writeDuplicate(int frame)
+{
+    if (!isWriting || frame < 0 || frame >= nextFrame)
+    {
+        return false;
+    }
+
+    // The index points the frame straight at the record it repeats, so only sequential reads see the reference
+    const int source = sourceFrames[frame];
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << quint8(SameAsFrame) << quint32(source);
+
+    recordOffsets.append(recordOffsets[source]);
+    sourceFrames.append(source);
+    stream << record;
+    nextFrame++;
+    return stream.status() == QDataStream::Ok;
+}
+
+int ProjectFile::getSourceFrame(int index) const
+{
+    return sourceFrames.value(index, index);
+}
+
+int ProjectFile::referencedFrame(const QByteArray &record) const
+{
+    if (formatVersion < SharedRecordVersion || record.size() != ReferenceRecordSize
+        || quint8(record.at(0)) != SameAsFrame)
+    {
+        return -1;
+    }
+    return int(qFromLittleEndian<quint32>(record.constData() + 1));
+}
+
+bool ProjectFile::indexRecords()
+{
+    if (isJson || isWriting || !file.isOpen())
+    {
+        return false;
+    }
+
+    // Records follow the header and palette, where a freshly opened file is positioned
+    const qint64 firstRecord = file.pos();
+    recordOffsets.clear();
+    sourceFrames.clear();
+
+    if (formatVersion >= IndexedVersion && file.size() >= firstRecord + 12 && file.seek(file.size() - 12))
+    {
+        quint64 indexOffset;
+        stream >> indexOffset;
+        const QByteArray magic = file.read(IndexMagic.size());
+
+        quint32 count = 0;
+        if (stream.status() == QDataStream::Ok && magic == IndexMagic
+            && indexOffset >= quint64(firstRecord) && file.seek(qint64(indexOffset)))
+        {
+            stream >> count;
+        }
+
+        // Offsets must rise through the records or repeat an earlier frame, anything else means the index is damaged
+        QHash<qint64, int> firstFrameAt;
+        qint64 previous = firstRecord - 1;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+        {
+            quint64 offset;
+            stream >> offset;
+            const bool repeat = formatVersion >= SharedRecordVersion && firstFrameAt.contains(qint64(offset));
+            if ((!repeat && qint64(offset) <= previous) || offset >= indexOffset)
+            {
+                break;
+            }
+            recordOffsets.append(qint64(offset));
+            sourceFrames.append(firstFrameAt.value(qint64(offset), int(i)));
+            firstFrameAt.insert(qint64(offset), sourceFrames.last());
+            previous = std::max(previous, qint64(offset));
+        }
+
+        if (stream.status() != QDataStream::Ok || recordOffsets.size() != frameCount)
+        {
+            qWarning() << "Damaged record index in" << fileName << "reading every record instead";
+            recordOffsets.clear();
+            sourceFrames.clear();
+            stream.resetStatus();
+        }
+    }
+
+    // Older projects are indexed by hopping over the length prefix of each record
+    if (recordOffsets.isEmpty() && file.seek(firstRecord))
+    {
+        for (int i = 0; i < frameCount; ++i)
+        {
+            const qint64 offset = file.pos();
+            quint32 length;
+            stream >> length;
+            const int source = length == quint32(ReferenceRecordSize) ? referencedFrame(file.peek(length)) : -1;
+            if (stream.status() != QDataStream::Ok || source >= i || (length != 0xFFFFFFFF
+                && (file.pos() + length > file.size() || !file.seek(file.pos() + length))))
+            {
+                qWarning() << "Project" << fileName << "is truncated at frame" << i;
+                recordOffsets.clear();
+                sourceFrames.clear();
+                file.seek(firstRecord);
+                return false;
+            }
+            recordOffsets.append(source >= 0 ? recordOffsets[source] : offset);
+            sourceFrames.append(source >= 0 ? sourceFrames[source] : i);
+        }
+    }
+
+    file.seek(firstRecord);
+    stream.resetStatus();
+    return recordOffsets.size() == frameCount;
+}
+
+bool ProjectFile::readRecordAt(int index, QByteArray &record)
+{
+    if (index < 0 || index >= recordOffsets.size() || !file.seek(recordOffsets[index]))
+    {
+        return false;
+    }
+
+    stream >> record;
+    if (stream.status() != QDataStream::Ok)
+    {
+        qWarning() << "Could not read frame" << index << "of" << fileName;
+        stream.resetStatus();
+        return false;
+    }
+    return true;
+}
+
+bool ProjectFile::close()
+{
+    bool ok = true;
+    if (saveFile.isOpen())
+    {
+        // The record index goes last, found from the fixed size fields at the very end
+        const qint64 indexOffset = saveFile.pos();
+        stream << quint32(recordOffsets.size());
+        for (qint64 offset : std::as_const(recordOffsets))
+        {
+            stream << quint64(offset);
+        }
+        stream << quint64(indexOffset);
+        stream.writeRawData(IndexMagic.constData(), IndexMagic.size());
+
+        // Keep the header honest if fewer frames were written than announced
+        if (nextFrame != frameCount && saveFile.seek(FrameCountOffset))
+        {
+            stream << quint32(nextFrame);
+            frameCount = nextFrame;
+        }
+
+        ok = stream.status() == QDataStream::Ok && saveFile.error() == QFileDevice::NoError;
+        stream.setDevice(nullptr);
+        if (!ok)
+        {
+            saveFile.cancelWriting();   // The previous project stays in place
+        }
+        ok = saveFile.commit() && ok;
+    }
+    else if (file.isOpen())
+    {
+        ok = stream.status() == QDataStream::Ok && file.error() == QFileDevice::NoError;
+        stream.setDevice(nullptr);
+        file.close();
+    }
+
+    isWriting = false;
+    return ok;
+}
+
+bool ProjectFile::isLegacyJson() const
+{
+    return isJson;
+}
+
+int ProjectFile::getFrameCount() const
+{
+    return frameCount;
+}
+
+int ProjectFile::getSpriteSize() const
+{
+    return spriteSize;
+}
+
+QVector<QRgb> ProjectFile::getPalette() const
+{
+    return palette;
+}
+
+QByteArray ProjectFile::encodeFrame(const QImage &frame)
+{
+    if (frame.format() == QImage::Format_Indexed8)
+    {
+        return encodeIndexed(frame);
+    }
+
+    const QImage argb = frame.convertToFormat(QImage::Format_ARGB32);
+    const int width = argb.width();
+    const int height = argb.height();
+
+    // Try to build a palette first, most sprites use only a handful of colors
+    QVector<QRgb> palette;
+    QHash<QRgb, uchar> lookup;
+    QByteArray indices(qsizetype(width) * height, Qt::Uninitialized);
+    bool indexed = true;
+
+    for (int y = 0; y < height && indexed; ++y)
+    {
+        const QRgb *row = PixelOps::constRow(argb, y);
+        uchar *out = reinterpret_cast<uchar *>(indices.data()) + qsizetype(y) * width;
+        for (int x = 0; x < width; ++x)
+        {
+            auto it = lookup.constFind(row[x]);
+            if (it == lookup.constEnd())
+            {
+                if (palette.size() == MaxPaletteSize)
+                {
+                    indexed = false;
+                    break;
+                }
+                it = lookup.insert(row[x], uchar(palette.size()));
+                palette.append(row[x]);
+            }
+            out[x] = it.value();
+        }
+    }
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    if (indexed)
+    {
+        out << quint16(palette.size());
+        for (QRgb color : palette)
+        {
+            out << quint32(color);
+        }
+        out.writeRawData(indices.constData(), indices.size());
+    }
+    else
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            const QRgb *row = PixelOps::constRow(argb, y);
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+            out.writeRawData(reinterpret_cast<const char *>(row), width * 4);
+#else
+            for (int x = 0; x < width; ++x)
+            {
+                out << quint32(row[x]);
+            }
+#endif
+        }
+    }
+
+    QByteArray record;
+    {
+        QDataStream header(&record, QIODevice::WriteOnly);
+        header.setByteOrder(QDataStream::LittleEndian);
+        header << quint8(indexed ? PaletteIndexed : RawArgb)
+               << quint32(width)
+               << quint32(height);
+    }
+    record.append(qCompress(payload));
+    return record;
+}
+
+QImage ProjectFile::decodeFrame(const QByteArray &record)
+{
+    QDataStream header(record);
+    header.setByteOrder(QDataStream::LittleEndian);
+
+    quint8 encoding;
+    quint32 width;
+    quint32 height;
+    header >> encoding >> width >> height;
+
+    if (header.status() != QDataStream::Ok || width == 0 || height == 0
+        || width > 32768 || height > 32768)
+    {
+        return QImage();
+    }
+
+    if (encoding == Layered)
+    {
+        return Compositor::flattened(decodeLayers(record)).convertToFormat(QImage::Format_ARGB32);
+    }
+
+    const QByteArray payload = qUncompress(record.mid(RecordHeaderSize));
+    const qsizetype pixelCount = qsizetype(width) * height;
+    QImage img(int(width), int(height), QImage::Format_ARGB32);
+
+    if (encoding == RawArgb)
+    {
+        if (payload.size() < pixelCount * 4)
+        {
+            return QImage();
+        }
+
+        const uchar *in = reinterpret_cast<const uchar *>(payload.constData());
+        for (int y = 0; y < img.height(); ++y)
+        {
+            QRgb *row = PixelOps::row(img, y);
+            for (int x = 0; x < img.width(); ++x)
+            {
+                row[x] = qFromLittleEndian<quint32>(in);
+                in += 4;
+            }
+        }
+    }
+    else if (encoding == PaletteIndexed)
+    {
+        QDataStream in(payload);
+        in.setByteOrder(QDataStream::LittleEndian);
+
+        quint16 paletteSize;
+        in >> paletteSize;
+        if (in.status() != QDataStream::Ok || paletteSize > MaxPaletteSize)
+        {
+            return QImage();
+        }
+
+        QRgb palette[MaxPaletteSize] = {};
+        for (int i = 0; i < paletteSize; ++i)
+        {
+            quint32 color;
+            in >> color;
+            palette[i] = color;
+        }
+
+        const qsizetype indexOffset = 2 + qsizetype(paletteSize) * 4;
+        if (in.status() != QDataStream::Ok || payload.size() < indexOffset + pixelCount)
+        {
+            return QImage();
+        }
+
+        const uchar *indices = reinterpret_cast<const uchar *>(payload.constData()) + indexOffset;
+        for (int y = 0; y < img.height(); ++y)
+        {
+            QRgb *row = PixelOps::row(img, y);
+            for (int x = 0; x < img.width(); ++x)
+            {
+                row[x] = palette[*indices++];
+            }
+        }
+    }
+    else if (encoding == SparseTiles)
+    {
+        QDataStream in(payload);
+        in.setByteOrder(QDataStream::LittleEndian);
+
+        quint16 tileSize;
+        quint32 tileCount;
+        in >> tileSize >> tileCount;
+        if (in.status() != QDataStream::Ok || tileSize == 0)
+        {
+            return QImage();
+        }
+
+        const quint32 columns = (width + tileSize - 1) / tileSize;
+        const quint32 rows = (height + tileSize - 1) / tileSize;
+        if (tileCount > columns * rows)
+        {
+            return QImage();
+        }
+
+        // Only the listed tiles were saved, everything else stays transparent
+        img = PixelOps::blankImage(img.size(), QImage::Format_ARGB32);
+        for (quint32 i = 0; i < tileCount; ++i)
+        {
+            quint16 column;
+            quint16 row;
+            in >> column >> row;
+            if (in.status() != QDataStream::Ok || column >= columns || row >= rows)
+            {
+                return QImage();
+            }
+
+            const QRect tile = QRect(column * tileSize, row * tileSize, tileSize, tileSize).intersected(img.rect());
+            for (int y = tile.top(); y <= tile.bottom(); ++y)
+            {
+                QRgb *line = PixelOps::row(img, y) + tile.left();
+                if (in.readRawData(reinterpret_cast<char *>(line), tile.width() * 4) != tile.width() * 4)
+                {
+                    return QImage();
+                }
+                qFromLittleEndian<quint32>(line, tile.width(), line);
+            }
+        }
+    }
+    else
+    {
+        return QImage();
+    }
+
+    return img;
+}
+
+QByteArray ProjectFile::encodeLayers(const QVector<Layer> &layers)
+{
+    if (layers.size() == 1 && layers.first().visible && layers.first().opacity == 255
+        && layers.first().blendMode == BlendMode::Normal)
+    {
+        return encodeLayerPixels(layers.first());
+    }
+
+    const QSize size = layers.isEmpty() ? QSize() : layers.first().image.size();
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << quint8(Layered)
+        << quint32(size.width())
+        << quint32(size.height())
+        << quint16(layers.size());
+
+    for (const Layer &layer : layers)
+    {
+        out << layer.name
+            << quint8(layer.visible)
+            << quint8(layer.opacity)
+            << quint8(layer.blendMode)
+            << encodeLayerPixels(layer);
+    }
+    return record;
+}
+
+QByteArray ProjectFile::encodeLayerPixels(const Layer &layer)
+{
+    if (!layer.occupied.isNull() && layer.occupied.count() * 2 < layer.occupied.tileCount())
+    {
+        return encodeTiles(layer.image, layer.occupied);
+    }
+    return encodeFrame(layer.image);
+}
+
+QByteArray ProjectFile::encodeIndexed(const QImage &frame)
+{
+    const int width = frame.width();
+    const int height = frame.height();
+
+    // Only the colors up to the highest index in use are stored
+    int used = 0;
+    for (int y = 0; y < height; ++y)
+    {
+        const uchar *row = frame.constScanLine(y);
+        used = qMax(used, int(*std::max_element(row, row + width)) + 1);
+    }
+
+    const QVector<QRgb> colors = frame.colorTable();
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << quint16(used);
+    for (int i = 0; i < used; ++i)
+    {
+        out << quint32(i < colors.size() ? colors[i] : 0);
+    }
+    for (int y = 0; y < height; ++y)
+    {
+        out.writeRawData(reinterpret_cast<const char *>(frame.constScanLine(y)), width);
+    }
+
+    QByteArray record;
+    {
+        QDataStream header(&record, QIODevice::WriteOnly);
+        header.setByteOrder(QDataStream::LittleEndian);
+        header << quint8(PaletteIndexed)
+               << quint32(width)
+               << quint32(height);
+    }
+    record.append(qCompress(payload));
+    return record;
+}
+
+QByteArray ProjectFile::encodeTiles(const QImage &frame, const TileSet &tiles)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << quint16(TileSet::TileSize) << quint32(tiles.count());
+
+    QVector<quint32> line(TileSet::TileSize);
+    for (int row = 0; row < tiles.rows(); ++row)
+    {
+        for (int column = 0; column < tiles.columns(); ++column)
+        {
+            if (!tiles.containsTile(column, row))
+            {
+                continue;
+            }
+
+            // Only this tile is converted, the rest of the frame is never read
+            const QImage tile = frame.copy(tiles.tileRect(column, row)).convertToFormat(QImage::Format_ARGB32);
+            out << quint16(column) << quint16(row);
+            for (int y = 0; y < tile.height(); ++y)
+            {
+                qToLittleEndian<quint32>(PixelOps::constRow(tile, y), tile.width(), line.data());
+                out.writeRawData(reinterpret_cast<const char *>(line.constData()), tile.width() * 4);
+            }
+        }
+    }
+
+    QByteArray record;
+    {
+        QDataStream header(&record, QIODevice::WriteOnly);
+        header.setByteOrder(QDataStream::LittleEndian);
+        header << quint8(SparseTiles)
+               << quint32(frame.width())
+               << quint32(frame.height());
+    }
+    record.append(qCompress(payload));
+    return record;
+}
+
+QVector<Layer> ProjectFile::decodeLayers(const QByteArray &record)
+{
+    QDataStream in(record);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint8 encoding;
+    quint32 width;
+    quint32 height;
+    in >> encoding >> width >> height;
+
+    if (in.status() != QDataStream::Ok)
+    {
+        return {};
+    }
+
+    if (encoding != Layered)
+    {
+        Layer layer;
+        layer.name = "Layer 1";
+        layer.image = decodeFrame(record);
+        return layer.image.isNull() ? QVector<Layer>() : QVector<Layer>{layer};
+    }
+
+    quint16 layerCount;
+    in >> layerCount;
+    if (in.status() != QDataStream::Ok || layerCount == 0 || layerCount > MaxLayerCount)
+    {
+        return {};
+    }
+
+    QVector<Layer> layers(layerCount);
+    for (Layer &layer : layers)
+    {
+        quint8 visible;
+        quint8 opacity;
+        quint8 blendMode;
+        QByteArray pixels;
+        in >> layer.name >> visible >> opacity >> blendMode >> pixels;
+        if (pixels.isEmpty() || quint8(pixels.at(0)) == Layered)
+        {
+            return {};  // Layers hold plain pixel records, never more layers
+        }
+
+        layer.visible = visible != 0;
+        layer.opacity = opacity;
+        layer.blendMode = blendMode <= quint8(BlendMode::Add) ? BlendMode(blendMode) : BlendMode::Normal;
+        layer.image = decodeFrame(pixels);
+
+        if (in.status() != QDataStream::Ok || layer.image.width() != int(width)
+            || layer.image.height() != int(height))
+        {
+            return {};
+        }
+    }
+    return layers;
+}
+
+bool ProjectFile::openJson(const QByteArray &data)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(data);
+    QJsonObject root = doc.object();
+
+    if (!root.contains("frames") || !root["frames"].isArray())
+    {
+        qWarning() << "Invalid file format: missing frames array";
+        return false;
+    }
+
+    isJson = true;
+    jsonFrames = root["frames"].toArray();
+    frameCount = jsonFrames.size();
+    spriteSize = frameCount > 0 ? jsonFrames[0].toObject()["spriteSize"].toInt() : 0;
+    return true;
+}
+
+QImage ProjectFile::decodeJsonFrame(const QJsonObject &spriteObj)
+{
+    if (!spriteObj.contains("spriteSize") || !spriteObj.contains("pixels"))
+    {
+        return QImage();
+    }
+
+    int size = spriteObj["spriteSize"].toInt();
+    if (size <= 0)
+    {
+        return QImage();
+    }
+
+    QImage img(size, size, QImage::Format_ARGB32);
+    img.fill(Qt::transparent);
+
+    QJsonArray rows = spriteObj["pixels"].toArray();
+    for (int y = 0; y < size && y < rows.size(); ++y)
+    {
+        QJsonArray row = rows[y].toArray();
+        QRgb *line = PixelOps::row(img, y);
+        for (int x = 0; x < size && x < row.size(); ++x)
+        {
+            QJsonObject pix = row[x].toObject();
+            line[x] = qRgba(pix["r"].toInt(),
+                            pix["g"].toInt(),
+                            pix["b"].toInt(),
+                            pix["a"].toInt());
+        }
+    }
+
+    return img;
+}
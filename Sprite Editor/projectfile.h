@@ -0,0 +1,259 @@
+/**
+ * Declaration of the ProjectFile class, which reads and writes .ssp project files.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer John Gibb
+ */
+
+#ifndef PROJECTFILE_H
+#define PROJECTFILE_H
+
+#include <QDataStream>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QString>
+#include <QVector>
+#include "layer.h"
+
+/**
+ * The ProjectFile class streams the frames of a .ssp project one at a time.
+ *
+ * Projects are written in a versioned binary container: a fixed header followed by
+ * one length-prefixed record per frame. Each record stores its frame either as raw
+ * ARGB rows or, when the frame uses 256 colors or fewer, as a palette plus one index
+ * byte per pixel, and the pixel data of every record is compressed on its own. Frames
+ * with more than one layer, or with a hidden, faded or blended layer, are stored as a
+ * layered record holding the settings of each layer followed by its own pixel record.
+ * Layers that have painted only a small part of the canvas are stored as sparse tiles,
+ * listing just the 64x64 tiles in use, so empty regions of large canvases take no space.
+ * Projects in indexed color mode also store their shared palette after the header, and
+ * their 8-bit layers are written as index records straight from their pixels. A frame
+ * identical to an earlier one is stored as a short reference to that frame instead of a
+ * second copy of its record. The file ends with an index of the offset of every record,
+ * where repeated frames point at the record they repeat, so a single frame can be read
+ * without reading those before it.
+ * Older projects saved as JSON are detected when opened and can still be read.
+ */
+class ProjectFile
+{
+public:
+
+    /**
+     * @brief Constructs a ProjectFile for the given path. No file is opened yet.
+     * @param fileName The path of the .ssp project file.
+     */
+    explicit ProjectFile(const QString &fileName);
+
+    /**
+     * @brief Opens the file for reading and reads its header.
+     * @return True if the file is a readable binary or JSON project.
+     */
+    bool openForRead();
+
+    /**
+     * @brief Opens the file for writing and writes the header. The frames are written to a
+     * temporary file that only replaces the project once close succeeds, so a failed or
+     * interrupted save leaves the previous project intact.
+     * @param spriteSize The side length of the frames that will be written.
+     * @param frameCount The number of frames that will be written.
+     * @param palette The palette of a project in indexed color mode, or empty for none.
+     * @return True if the file could be opened.
+     */
+    bool openForWrite(int spriteSize, int frameCount, const QVector<QRgb> &palette = QVector<QRgb>());
+
+    /**
+     * @brief Reads the next frame of the project. Frames that cannot be decoded are skipped.
+     * @param frame Set to the decoded frame.
+     * @return True if a frame was read, false once every frame has been read.
+     */
+    bool readFrame(QImage &frame);
+
+    /**
+     * @brief Reads the next frame record of a binary project without decoding it, so that
+     * decoding can happen elsewhere. Not available for legacy JSON projects.
+     * @param record Set to the encoded record, which decodeFrame turns into a frame.
+     * @return True if a record was read, false once every record has been read.
+     */
+    bool readRecord(QByteArray &record);
+
+    /**
+     * @brief Finds where every frame record of a binary project starts, from the index at the
+     * end of the file, or by skipping from record to record in projects saved before the index
+     * existed. Not available for legacy JSON projects.
+     * @return True if every record was found.
+     */
+    bool indexRecords();
+
+    /**
+     * @brief Reads a frame record of an indexed project without reading those before it.
+     * @param index The position of the frame in the project.
+     * @param record Set to the encoded record.
+     * @return True if the record was read.
+     */
+    bool readRecordAt(int index, QByteArray &record);
+
+    /**
+     * @brief Appends a frame to the project.
+     * @param frame The frame to write.
+     * @return True if the frame was written.
+     */
+    bool writeFrame(const QImage &frame);
+
+    /**
+     * @brief Appends a frame record that was already produced by encodeFrame.
+     * @param record The encoded record to write.
+     * @return True if the record was written.
+     */
+    bool writeRecord(const QByteArray &record);
+
+    /**
+     * @brief Appends a frame identical to one already written, stored as a reference to it.
+     * @param frame The position of the earlier frame it repeats.
+     * @return True if the frame was written.
+     */
+    bool writeDuplicate(int frame);
+
+    /**
+     * @brief Gets the first frame whose record a frame of an indexed project is read from.
+     * @param index The position of the frame in the project.
+     * @return The frame itself, or the earlier frame it was saved as a duplicate of.
+     */
+    int getSourceFrame(int index) const;
+
+    /**
+     * @brief Closes the file. A project being written replaces the file at its path only if
+     * every write succeeded.
+     * @return True if every write succeeded.
+     */
+    bool close();
+
+    /**
+     * @brief Returns whether the opened file is a legacy JSON project.
+     */
+    bool isLegacyJson() const;
+
+    /**
+     * @brief Gets the number of frames stored in the project.
+     */
+    int getFrameCount() const;
+
+    /**
+     * @brief Gets the side length of the frames stored in the project.
+     */
+    int getSpriteSize() const;
+
+    /**
+     * @brief Gets the palette of a project saved in indexed color mode.
+     * @return The non-premultiplied ARGB32 colors, or an empty vector if the project has no palette.
+     */
+    QVector<QRgb> getPalette() const;
+
+    /**
+     * @brief Encodes a frame into a single self-contained binary record. 8-bit indexed frames keep
+     * their indices and color table as they are.
+     * @param frame The frame to encode.
+     * @return The encoded record.
+     */
+    static QByteArray encodeFrame(const QImage &frame);
+
+    /**
+     * @brief Decodes a record produced by encodeFrame.
+     * @param record The encoded record.
+     * @return The decoded frame, or a null image if the record is corrupt.
+     */
+    static QImage decodeFrame(const QByteArray &record);
+
+    /**
+     * @brief Encodes the layers of a frame into a single self-contained binary record. A frame
+     * with a single plain layer is encoded exactly like encodeFrame would encode its image, unless
+     * its occupied tiles cover less than half of it, in which case only those tiles are stored.
+     * @param layers The layers of the frame, bottom layer first.
+     * @return The encoded record.
+     */
+    static QByteArray encodeLayers(const QVector<Layer> &layers);
+
+    /**
+     * @brief Decodes the layers of a record produced by encodeLayers or encodeFrame.
+     * @param record The encoded record.
+     * @return The layers of the frame, bottom layer first, or an empty vector if the record is corrupt.
+     */
+    static QVector<Layer> decodeLayers(const QByteArray &record);
+
+private:
+
+    // How the pixels of a frame record are stored.
+    enum FrameEncoding : quint8
+    {
+        RawArgb = 0,
+        PaletteIndexed = 1,
+        Layered = 2,
+        SparseTiles = 3,
+        SameAsFrame = 4
+    };
+
+    // Gets the frame a record refers to, or -1 if it is a record of its own.
+    int referencedFrame(const QByteArray &record) const;
+
+    // Encodes the pixels of a layer, as sparse tiles when it is mostly empty.
+    static QByteArray encodeLayerPixels(const Layer &layer);
+
+    // Encodes the pixels of an 8-bit indexed frame as an index record without looking up any color.
+    static QByteArray encodeIndexed(const QImage &frame);
+
+    // Encodes only the given tiles of a frame, the rest of it being transparent.
+    static QByteArray encodeTiles(const QImage &frame, const TileSet &tiles);
+
+    // Parses a legacy JSON project into jsonFrames.
+    bool openJson(const QByteArray &data);
+
+    // Decodes a single frame object of a legacy JSON project.
+    static QImage decodeJsonFrame(const QJsonObject &spriteObj);
+
+    // The path of the project file.
+    QString fileName;
+
+    // The underlying file being read.
+    QFile file;
+
+    // The underlying file being written, renamed over the project when committed.
+    QSaveFile saveFile;
+
+    // The stream used for the binary container.
+    QDataStream stream;
+
+    // The frames of a legacy JSON project, empty for binary projects.
+    QJsonArray jsonFrames;
+
+    // True if the opened file is a legacy JSON project.
+    bool isJson = false;
+
+    // True if the file was opened for writing.
+    bool isWriting = false;
+
+    // The version of the binary container being read.
+    quint16 formatVersion = 0;
+
+    // The number of frames stored in the project.
+    int frameCount = 0;
+
+    // The side length of the frames stored in the project.
+    int spriteSize = 0;
+
+    // The palette of a project in indexed color mode, empty otherwise.
+    QVector<QRgb> palette;
+
+    // The index of the next frame to be read or written.
+    int nextFrame = 0;
+
+    // Where each frame record starts in the file, once read or written.
+    QVector<qint64> recordOffsets;
+
+    // The first frame stored in the same record as each frame, once read or written.
+    QVector<int> sourceFrames;
+};
+
+#endif // PROJECTFILE_H
@@ -7,20 +7,51 @@
  */
 
 #include "sprite.h"
+#include "compositor.h"
+#include "diagnostics.h"
+#include "pixelops.h"
+
+#include <QDebug>
+#include <QTimer>
+
+namespace
+{
+// Source of sprite versions, shared so that no two sprites ever hold the same version.
+quint64 lastVersion = 0;
+}
 
 Sprite::Sprite(int size, QWidget *parent)
     : QLabel(parent)
     , spriteSize(size)
+    , version(++lastVersion)
 {
     setSpriteSize(size);
 }
 
 Sprite::Sprite(const Sprite &other)
     : QLabel(nullptr)
-    , image(other.image.copy())
+    , layers(other.layers)
+    , activeLayer(other.activeLayer)
+    , flattened(other.flattened)
+    , flattenDirty(other.flattenDirty)
+    , flattenPainted(other.flattenPainted)
     , spriteSize(other.spriteSize)
+    , version(++lastVersion)
+    , stored(other.stored)
+    , contentHash(other.contentHash)
+    , contentHashCompact(other.contentHashCompact)
 {
+    // A copy of an unloaded or unchanged sprite shares its stored pixels
+    storedVersion = other.storedVersion == other.version ? version : 0;
 
+    // The layers and composite are shallow copies, writing to either sprite detaches its own
+    contentHashVersion = other.contentHashVersion == other.version ? version : 0;
+    if (flattenDirty.isNull())
+    {
+        flattenDirty = TileSet(QSize(spriteSize, spriteSize));
+        flattenDirty.insert(QRect(0, 0, spriteSize, spriteSize));
+    }
+    viewport.setCanvasSize(spriteSize);
 }
 
 Sprite::~Sprite()
@@ -31,8 +62,16 @@ Sprite::~Sprite()
 void Sprite::setSpriteSize(int newSize)
 {
     spriteSize = newSize;
-    image = QImage(spriteSize, spriteSize, QImage::Format_ARGB32);
-    image.fill(Qt::transparent);
+    Layer layer;
+    layer.name = "Layer 1";
+    layer.image = PixelOps::blankImage(QSize(spriteSize, spriteSize), QImage::Format_ARGB32_Premultiplied);
+    layer.occupied = TileSet(layer.image.size());
+    layers = {layer};
+    activeLayer = 0;
+    stored = StoredFrame();
+    history.clear();
+    clearSelection();
+    invalidateBacking();
 }
 
 int Sprite::getSpriteSize() const
@@ -40,31 +79,446 @@ int Sprite::getSpriteSize() const
     return spriteSize;
 }
 
-const QImage &Sprite::getImage() const
+QImage Sprite::getImage() const
 {
-    return image;
+    if (!isLoaded())
+    {
+        return Compositor::flattened(stored.decode());
+    }
+    if (isCompact())
+    {
+        return Compositor::flattened(layers);
+    }
+
+    // A single opaque layer painted normally is its own composite, and needs no copy of it
+    const Layer &bottom = layers.first();
+    if (layers.size() == 1 && bottom.visible && bottom.opacity == 255 && bottom.blendMode == BlendMode::Normal)
+    {
+        flattened = QImage();
+        return bottom.image;
+    }
+
+    if (flattened.size() != QSize(spriteSize, spriteSize))
+    {
+        flattened = PixelOps::blankImage(QSize(spriteSize, spriteSize), QImage::Format_ARGB32_Premultiplied);
+        flattenDirty = TileSet(flattened.size());
+        flattenDirty.insert(flattened.rect());
+        flattenPainted = TileSet(flattened.size());
+    }
+
+    if (!flattenDirty.isEmpty())
+    {
+        // Out of date tiles are only composited where a layer painted or the composite still holds
+        // pixels to clear, the rest of a blank composite is never written
+        const TileSet visible = Compositor::visibleTiles(layers, flattened.size());
+        TileSet needed = visible;
+        for (const QRect &rect : flattenPainted.rects(flattened.rect()))
+        {
+            needed.insert(rect);
+        }
+        for (const QRect &rect : flattenDirty.rects(flattened.rect()))
+        {
+            for (const QRect &part : needed.rects(rect))
+            {
+                Compositor::flatten(flattened, layers, part);
+            }
+        }
+        flattenDirty.clear();
+        flattenPainted = visible;
+    }
+    return flattened;
 }
 
 void Sprite::setImage(const QImage &newImage)
 {
     if (newImage.isNull())
     {
-        image = QImage(2, 2, QImage::Format_ARGB32);
-        image.fill(Qt::transparent);
-        spriteSize = 2;
+        setSpriteSize(2);
+        return;
     }
-    else
+
+    Layer layer;
+    layer.name = "Layer 1";
+    layer.image = newImage;
+    setLayers({layer});
+}
+
+const QVector<Layer> &Sprite::getLayers() const
+{
+    return layers;
+}
+
+void Sprite::setLayers(const QVector<Layer> &newLayers)
+{
+    if (newLayers.isEmpty())
+    {
+        setSpriteSize(2);
+        return;
+    }
+
+    layers = newLayers;
+    stored = StoredFrame();
+    spriteSize = layers.first().image.width();
+    for (Layer &layer : layers)
+    {
+        // Painting and compositing both work on premultiplied pixels, so they are converted once here
+        layer.image = layer.image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        layer.occupied = TileSet::fromImage(layer.image);
+    }
+    activeLayer = int(layers.size()) - 1;
+    history.clear();
+    clearSelection();
+    invalidateBacking();
+}
+
+bool Sprite::compact(ColorPalette &palette)
+{
+    if (!isLoaded() || isCompact())
+    {
+        return true;
+    }
+
+    // Every layer is indexed before any is replaced, so a palette overflow leaves the sprite as it was
+    const int oldSize = palette.size();
+    QVector<QImage> indexed;
+    for (const Layer &layer : std::as_const(layers))
+    {
+        indexed.append(palette.indexImage(layer.image));
+        if (indexed.last().isNull())
+        {
+            palette.setColors(palette.getColors().mid(0, oldSize));
+            return false;
+        }
+    }
+
+    // Layers indexed before the palette grew get the full table, as every index they use is unchanged
+    for (int i = 0; i < layers.size(); ++i)
+    {
+        layers[i].image = indexed[i];
+        layers[i].image.setColorTable(palette.getColors());
+    }
+    flattened = QImage();
+    viewport.clearCache();
+    return true;
+}
+
+void Sprite::expand()
+{
+    load();
+    if (!isCompact())
+    {
+        return;
+    }
+
+    for (Layer &layer : layers)
+    {
+        layer.image = ColorPalette::expandImage(layer.image);
+    }
+    flattenDirty = TileSet(QSize(spriteSize, spriteSize));
+    flattenDirty.insert(QRect(0, 0, spriteSize, spriteSize));
+}
+
+bool Sprite::isCompact() const
+{
+    return !layers.isEmpty() && layers.first().image.format() == QImage::Format_Indexed8;
+}
+
+void Sprite::setUnloaded(const StoredFrame &frame, int size)
+{
+    spriteSize = size;
+    layers.clear();
+    activeLayer = -1;   // The top layer, once loaded
+    flattened = QImage();
+    history.clear();
+    clearSelection();
+    invalidateBacking();
+    stored = frame;
+    storedVersion = version;
+}
+
+void Sprite::setStoredFrame(const StoredFrame &frame)
+{
+    stored = frame;
+    storedVersion = version;
+}
+
+StoredFrame Sprite::getStoredFrame() const
+{
+    return storedVersion == version ? stored : StoredFrame();
+}
+
+void Sprite::load()
+{
+    if (isLoaded())
+    {
+        return;
+    }
+
+    layers = stored.decode();
+    if (layers.isEmpty() || layers.first().image.width() != spriteSize)
+    {
+        qWarning() << "A frame could not be decoded and is shown blank";
+        Layer layer;
+        layer.name = "Layer 1";
+        layer.image = PixelOps::blankImage(QSize(spriteSize, spriteSize), QImage::Format_ARGB32_Premultiplied);
+        layer.occupied = TileSet(layer.image.size());
+        layers = {layer};
+    }
+
+    if (activeLayer < 0 || activeLayer >= layers.size())
+    {
+        activeLayer = int(layers.size()) - 1;
+    }
+    flattenDirty = TileSet(QSize(spriteSize, spriteSize));
+    flattenDirty.insert(QRect(0, 0, spriteSize, spriteSize));
+}
+
+bool Sprite::unload()
+{
+    if (!isLoaded())
+    {
+        return true;
+    }
+    if (!floating.isNull())
+    {
+        return false;
+    }
+
+    if (storedVersion != version || stored.isNull())
+    {
+        stored = StoredFrame();
+        stored.record = ProjectFile::encodeLayers(layers);
+        storedVersion = version;
+    }
+    layers.clear();
+    flattened = QImage();
+    viewport.clearCache();
+    return true;
+}
+
+bool Sprite::isLoaded() const
+{
+    return !layers.isEmpty();
+}
+
+size_t Sprite::getContentHash() const
+{
+    if (!isLoaded())
+    {
+        return 0;
+    }
+    if (contentHashVersion == version && contentHashCompact == isCompact())
+    {
+        return contentHash;
+    }
+
+    // Rows are hashed without their padding, which 8-bit layers may leave uninitialized
+    size_t hash = qHash(layers.size());
+    for (const Layer &layer : layers)
+    {
+        hash = qHashMulti(hash, layer.name, layer.visible, layer.opacity, quint8(layer.blendMode),
+                          int(layer.image.format()));
+        const qsizetype rowBytes = qsizetype(layer.image.width()) * layer.image.depth() / 8;
+        for (int y = 0; y < layer.image.height(); ++y)
+        {
+            hash = qHashBits(layer.image.constScanLine(y), size_t(rowBytes), hash);
+        }
+    }
+
+    contentHash = hash;
+    contentHashVersion = version;
+    contentHashCompact = isCompact();
+    return hash;
+}
+
+bool Sprite::hasSameContent(const Sprite &other) const
+{
+    if (!isLoaded() || !other.isLoaded() || layers.size() != other.layers.size())
+    {
+        return false;
+    }
+
+    for (int i = 0; i < layers.size(); ++i)
+    {
+        const Layer &a = layers[i];
+        const Layer &b = other.layers[i];
+        if (a.name != b.name || a.visible != b.visible || a.opacity != b.opacity || a.blendMode != b.blendMode
+            || a.image != b.image)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Sprite::shareLayers(const Sprite &other)
+{
+    for (int i = 0; i < layers.size() && i < other.layers.size(); ++i)
+    {
+        layers[i].image = other.layers[i].image;
+        layers[i].occupied = other.layers[i].occupied;
+    }
+
+    // The composite of the other sprite is just as valid for this one once it is up to date
+    if (!isCompact() && !other.flattened.isNull() && other.flattenDirty.isEmpty())
+    {
+        flattened = other.flattened;
+        flattenDirty.clear();
+        flattenPainted = other.flattenPainted;
+    }
+}
+
+void Sprite::setColorTable(const QVector<QRgb> &colors)
+{
+    if (!isCompact())
+    {
+        return;
+    }
+
+    // Recorded strokes hold full colors, which are recolored to match, so undo keeps the new colors
+    history.recolor(premultipliedChanges(layers.first().image.colorTable(), colors));
+    for (Layer &layer : layers)
+    {
+        layer.image.setColorTable(colors);
+    }
+    viewport.clearCache();
+    update();
+    bumpVersion();
+}
+
+bool Sprite::recolorUnloaded(const QVector<QRgb> &from, const QVector<QRgb> &to)
+{
+    if (isLoaded() || !stored.recolor(from, to))
     {
-        image = newImage.copy();
-        spriteSize = image.width();
+        return false;
+    }
+    history.recolor(premultipliedChanges(from, to));
+
+    // The stored pixels carry the change, so they are still an exact copy of the new version
+    bumpVersion();
+    storedVersion = version;
+    return true;
+}
+
+QHash<QRgb, QRgb> Sprite::premultipliedChanges(const QVector<QRgb> &from, const QVector<QRgb> &to)
+{
+    QHash<QRgb, QRgb> changes;
+    for (int i = 0; i < from.size() && i < to.size(); ++i)
+    {
+        if (from[i] != to[i] && !changes.contains(qPremultiply(from[i])))
+        {
+            changes.insert(qPremultiply(from[i]), qPremultiply(to[i]));
+        }
+    }
+    return changes;
+}
+
+int Sprite::getLayerCount() const
+{
+    return int(layers.size());
+}
+
+int Sprite::getActiveLayer() const
+{
+    return activeLayer;
+}
+
+void Sprite::setActiveLayer(int index)
+{
+    if (index >= 0 && index < layers.size())
+    {
+        activeLayer = index;
+    }
+}
+
+int Sprite::addLayer(const QString &name)
+{
+    Layer layer;
+    layer.name = name;
+    layer.image = PixelOps::blankImage(QSize(spriteSize, spriteSize), QImage::Format_ARGB32_Premultiplied);
+    layer.occupied = TileSet(layer.image.size());
+
+    activeLayer++;
+    layers.insert(activeLayer, layer);
+    history.clear();    // Recorded strokes refer to layers by index
+    bumpVersion();      // An empty layer does not change the composite, only the layer list
+    return activeLayer;
+}
+
+void Sprite::removeLayer(int index)
+{
+    if (layers.size() <= 1 || index < 0 || index >= layers.size())
+    {
+        return;
+    }
+
+    layers.removeAt(index);
+    if (activeLayer >= layers.size() || activeLayer > index)
+    {
+        activeLayer--;
+    }
+    activeLayer = qMax(0, activeLayer);
+    history.clear();
+    recomposite({QRect(0, 0, spriteSize, spriteSize)});
+}
+
+void Sprite::moveLayer(int from, int to)
+{
+    if (from == to || from < 0 || from >= layers.size() || to < 0 || to >= layers.size())
+    {
+        return;
+    }
+
+    layers.move(from, to);
+    if (activeLayer == from)
+    {
+        activeLayer = to;
+    }
+    else if (from < activeLayer && to >= activeLayer)
+    {
+        activeLayer--;
+    }
+    else if (from > activeLayer && to <= activeLayer)
+    {
+        activeLayer++;
+    }
+    history.clear();
+    recomposite({QRect(0, 0, spriteSize, spriteSize)});
+}
+
+void Sprite::setLayerVisible(int index, bool visible)
+{
+    if (index >= 0 && index < layers.size() && layers[index].visible != visible)
+    {
+        layers[index].visible = visible;
+        recomposite({QRect(0, 0, spriteSize, spriteSize)});
+    }
+}
+
+void Sprite::setLayerOpacity(int index, int opacity)
+{
+    opacity = qBound(0, opacity, 255);
+    if (index >= 0 && index < layers.size() && layers[index].opacity != opacity)
+    {
+        layers[index].opacity = opacity;
+        recomposite({QRect(0, 0, spriteSize, spriteSize)});
+    }
+}
+
+void Sprite::setLayerBlendMode(int index, BlendMode mode)
+{
+    if (index >= 0 && index < layers.size() && layers[index].blendMode != mode)
+    {
+        layers[index].blendMode = mode;
+        recomposite({QRect(0, 0, spriteSize, spriteSize)});
     }
 }
 
 QColor Sprite::getPixel(int x, int y) const
 {
-    if (x >= 0 && x < spriteSize && y >= 0 && y < spriteSize)
+    if (isLoaded() && x >= 0 && x < spriteSize && y >= 0 && y < spriteSize)
     {
-        return image.pixelColor(x, y);
+        return activeImage().pixelColor(x, y);  // Reads premultiplied and indexed layers alike
     }
     else
     {
@@ -76,10 +530,154 @@ void Sprite::setPixel(int x, int y, const QColor &color)
 {
     if (x >= 0 && x < spriteSize && y >= 0 && y < spriteSize)
     {
-        image.setPixelColor(x, y, color);
+        scanLine(y)[x] = qPremultiply(color.rgba());
+        layers[activeLayer].occupied.insert(QRect(x, y, 1, 1));
+    }
+}
+
+const QRgb *Sprite::constScanLine(int y) const
+{
+    // Unloaded sprites have no rows to read, and compact ones hold 8-bit indices rather than pixels
+    if (!isLoaded() || isCompact() || y < 0 || y >= spriteSize)
+    {
+        return nullptr;
+    }
+    return PixelOps::constRow(activeImage(), y);
+}
+
+QRgb *Sprite::scanLine(int y)
+{
+    return PixelOps::row(activeImage(), y);
+}
+
+void Sprite::fill(QRgb color)
+{
+    QImage &image = activeImage();
+    markDirty(PixelOps::fillRect(image, image.rect(), qPremultiply(color)));
+}
+
+QRect Sprite::fillRect(const QRect &rect, QRgb color)
+{
+    QRect changed = PixelOps::fillRect(activeImage(), rect, qPremultiply(color));
+    markDirty(changed);
+    return changed;
+}
+
+QRect Sprite::blit(const QImage &source, const QPoint &topLeft)
+{
+    QRect changed = PixelOps::blit(activeImage(), source.convertToFormat(QImage::Format_ARGB32_Premultiplied), topLeft);
+    markDirty(changed);
+    return changed;
+}
+
+QRect Sprite::floodFill(const QPoint &start, QRgb color)
+{
+    // Only the tiles the fill reaches are saved, as each span is about to be filled
+    QImage &image = activeImage();
+    history.beginTiledStroke(image.size());
+    QRect changed = PixelOps::floodFill(image, start, qPremultiply(color), [&](const QRect &span) {
+        history.captureTiles(image, span);
+    });
+    history.endStroke(image, changed, activeLayer);
+    markDirty(changed);
+    return changed;
+}
+
+QRect Sprite::replaceColor(QRgb from, QRgb to)
+{
+    if (from == to)
+    {
+        return QRect();
+    }
+
+    QImage &image = activeImage();
+    history.beginTiledStroke(image.size());
+    QRect changed = PixelOps::replaceColor(image, qPremultiply(from), qPremultiply(to), [&](const QRect &pixels) {
+        history.captureTiles(image, pixels);
+    });
+    history.endStroke(image, changed, activeLayer);
+    markDirty(changed);
+    return changed;
+}
+
+bool Sprite::hasSelection() const
+{
+    return !selection.isEmpty();
+}
+
+QRect Sprite::getSelection() const
+{
+    return selection;
+}
+
+void Sprite::selectRect(const QRect &rect)
+{
+    selection = rect.normalized().intersected(QRect(0, 0, spriteSize, spriteSize));
+    selectionMask = QImage();
+    selectionOutline.clear();
+    update();
+}
+
+void Sprite::clearSelection()
+{
+    selection = QRect();
+    selectionMask = QImage();
+    selectionOutline.clear();
+    update();
+}
+
+void Sprite::flipSelection(Qt::Orientation orientation)
+{
+    if (orientation == Qt::Horizontal)
+    {
+        transformSelection([](QImage image) {
+            PixelOps::flipHorizontal(image);
+            return image;
+        }, [](const QPoint &point, const QSize &size) {
+            return QPoint(size.width() - 1 - point.x(), point.y());
+        });
+    }
+    else
+    {
+        transformSelection([](QImage image) {
+            PixelOps::flipVertical(image);
+            return image;
+        }, [](const QPoint &point, const QSize &size) {
+            return QPoint(point.x(), size.height() - 1 - point.y());
+        });
     }
 }
 
+void Sprite::rotateSelection(bool clockwise)
+{
+    transformSelection([clockwise](const QImage &image) {
+        return PixelOps::rotated90(image, clockwise);
+    }, [clockwise](const QPoint &point, const QSize &size) {
+        return clockwise ? QPoint(size.height() - 1 - point.y(), point.x())
+                         : QPoint(point.y(), size.width() - 1 - point.x());
+    });
+}
+
+void Sprite::scaleSelection(double factor)
+{
+    if (factor <= 0)
+    {
+        return;
+    }
+
+    transformSelection([factor](const QImage &image) {
+        const QSize size(qMax(1, qRound(image.width() * factor)), qMax(1, qRound(image.height() * factor)));
+        return PixelOps::scaledNearest(image, size);
+    }, [factor](const QPoint &point, const QSize &) {
+        return QPoint(qRound(point.x() * factor), qRound(point.y() * factor));
+    });
+}
+
+QImage Sprite::convertedImage(QImage::Format format) const
+{
+    return getImage().convertToFormat(format);
+}
+
 void Sprite::setPencil(Pencil *pencil)
 {
     this->pencil = pencil;
@@ -99,23 +697,98 @@ void Sprite::setQFrame(QFrame *frame)
     frameHeight = frame->height();
 }
 
+void Sprite::setUnderlay(const QImage &newUnderlay)
+{
+    if (newUnderlay.cacheKey() == underlay.cacheKey())
+    {
+        return;
+    }
+
+    // The underlay is part of every cached block
+    underlay = newUnderlay;
+    viewport.clearCache();
+    update();
+}
+
+CanvasViewport::View Sprite::getView() const
+{
+    return viewport.getView();
+}
+
+void Sprite::setView(const CanvasViewport::View &view)
+{
+    viewport.setView(view);
+    update();
+}
+
+qsizetype Sprite::getUndoMemoryUsage() const
+{
+    return history.getMemoryUsage();
+}
+
+qsizetype Sprite::getMemoryUsage() const
+{
+    qsizetype bytes = flattened.sizeInBytes() + history.getMemoryUsage() + stored.record.size();
+    for (const Layer &layer : layers)
+    {
+        bytes += layer.image.sizeInBytes();
+    }
+    return bytes;
+}
+
+qsizetype Sprite::getMemoryUsage(QSet<qint64> &counted) const
+{
+    qsizetype bytes = history.getMemoryUsage() + stored.record.size();
+    if (!flattened.isNull() && !counted.contains(flattened.cacheKey()))
+    {
+        counted.insert(flattened.cacheKey());
+        bytes += flattened.sizeInBytes();
+    }
+    for (const Layer &layer : layers)
+    {
+        if (!counted.contains(layer.image.cacheKey()))
+        {
+            counted.insert(layer.image.cacheKey());
+            bytes += layer.image.sizeInBytes();
+        }
+    }
+    return bytes;
+}
+
+void Sprite::setUndoMemoryBudget(qsizetype bytes)
+{
+    history.setMemoryBudget(bytes);
+}
+
 void Sprite::undoPaint()
 {
-    if (!undoStack.empty())
+    expand();
+    int target = history.undoTarget();
+    if (target >= 0 && target < layers.size())
     {
-        redoStack.push(image);
-        image = undoStack.pop();    // Sets current image to previous undo stack element
-        update();
+        // Restores the pixels from before the last stroke
+        const QVector<QRect> changed = history.undo(layers[target].image);
+        for (const QRect &rect : changed)
+        {
+            layers[target].occupied.insert(rect);
+        }
+        recomposite(changed);
     }
 }
 
 void Sprite::redoPaint()
 {
-    if (!redoStack.empty())
+    expand();
+    int target = history.redoTarget();
+    if (target >= 0 && target < layers.size())
     {
-        undoStack.push(image);
-        image = redoStack.pop();    // Sets current image to previous redo stack element
-        update();
+        // Restores the pixels from after the undone stroke
+        const QVector<QRect> changed = history.redo(layers[target].image);
+        for (const QRect &rect : changed)
+        {
+            layers[target].occupied.insert(rect);
+        }
+        recomposite(changed);
     }
 }
 
@@ -127,11 +800,92 @@ void Sprite::setEyedropper(bool active){
     eyeDropperEnabled = active;
 }
 
-void Sprite::paintEvent(QPaintEvent *)
+quint64 Sprite::getVersion() const
 {
-    QPainter painter(this);
-    painter.drawImage(rect(), getImage());  // Draws the sprite as a QImage and emits update
-    emit spriteUpdated();
+    return version;
+}
+
+void Sprite::markDirty(const QRect &pixels)
+{
+    if (pixels.isEmpty())
+    {
+        inputPending = false;   // Nothing will be painted for the input
+        return;
+    }
+
+    layers[activeLayer].occupied.insert(pixels);
+    recomposite({pixels});
+}
+
+void Sprite::recomposite(const QVector<QRect> &regions)
+{
+    bool changed = false;
+    for (const QRect &pixels : regions)
+    {
+        flattenDirty.insert(pixels);
+    }
+
+    for (const QRect &pixels : regions)
+    {
+        if (!pixels.isEmpty())
+        {
+            viewport.invalidate(pixels);
+            update(viewport.pixelRectToWidget(pixels));  // Only the mapped region is repainted
+            changed = true;
+        }
+    }
+
+    if (changed)
+    {
+        bumpVersion();
+    }
+}
+
+void Sprite::paintEvent(QPaintEvent *event)
+{
+    {
+        Diagnostics::Scope scope("paint", "canvas");
+        QPainter painter(this);
+        viewport.paint(painter, event->rect(), getImage(), underlay);    // Blits the cached scaled blocks in view
+        paintSelection(painter);
+    }
+
+    if (inputPending)
+    {
+        inputPending = false;
+        Diagnostics::recordSince("input to pixel", "canvas", inputStart);
+    }
+}
+
+void Sprite::resizeEvent(QResizeEvent *event)
+{
+    QLabel::resizeEvent(event);
+    viewport.setWidgetSize(event->size());
+}
+
+void Sprite::wheelEvent(QWheelEvent *event)
+{
+    // Touchpads send small deltas, so they are added up into whole zoom steps
+    wheelRemainder += event->angleDelta().y();
+    const int steps = wheelRemainder / QWheelEvent::DefaultDeltasPerStep;
+    wheelRemainder -= steps * QWheelEvent::DefaultDeltasPerStep;
+
+    if (steps != 0 && viewport.zoomAt(steps, event->position().toPoint()))
+    {
+        update();
+    }
+    event->accept();
+}
+
+void Sprite::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::MiddleButton)   // Middle double click fits the sprite to the canvas again
+    {
+        viewport.fit();
+        update();
+        return;
+    }
+    QLabel::mouseDoubleClickEvent(event);
 }
 
 void Sprite::mousePressEvent(QMouseEvent *event)
@@ -142,50 +896,384 @@ void Sprite::mousePressEvent(QMouseEvent *event)
         focused->clearFocus();
     }
 
+    if (event->button() == Qt::MiddleButton)   // Middle drag pans the view
+    {
+        panning = true;
+        panOrigin = event->pos();
+        setCursor(Qt::ClosedHandCursor);
+        return;
+    }
+    if (event->button() != Qt::LeftButton || strokeActive)
+    {
+        return;
+    }
+
     QPoint pt = mousePos2Px(event -> pos());
     if (eyeDropperEnabled)
     {
-        emit changeColor(image.pixelColor(pt)); // Eyedropper tool changes color and deactivates
+        emit changeColor(getPixel(pt.x(), pt.y())); // Eyedropper tool changes color and deactivates
         setEyedropper(false);
         emit disableDropper();
     }
-    else
+    else if (pencil && pencil->getSelectMode())
+    {
+        selectionPress(pt);
+    }
+    else if (pencil && pencil->getFillMode())
     {
-        undoStack.push(image);  // Handles stack data for undo and redo
-        redoStack.clear();
-        if (pencil->getMode())  // determines the current tool mode
+        noteInput();
+        QRgb color = pencil->getColor().rgba();
+        if (event->modifiers() & Qt::ShiftModifier)   // Shift replaces the clicked color everywhere
         {
-            pencil->draw(pt.x(), pt.y(), image, spriteSize);
+            replaceColor(getPixel(pt.x(), pt.y()).rgba(), color);
         }
         else
         {
-            pencil->erase(pt.x(), pt.y(), image, spriteSize);
+            floodFill(pt, color);
         }
     }
-    update();
+    else
+    {
+        noteInput();
+        history.beginTiledStroke(activeImage().size());  // Recorded as a single undo entry on release
+        strokeRect = QRect();
+        strokeActive = true;
+        lastStrokePoint = pt;
+        pendingStroke = {pt};
+        flushStroke();  // The first dab shows up immediately
+    }
 }
 
 void Sprite::mouseMoveEvent(QMouseEvent *event)
 {
-    if (event->buttons() & Qt::LeftButton) 
+    if (panning)
     {
-        QPoint pt = mousePos2Px(event->pos());  // Gets current position of the mouse
-        if (pencil->getMode())
+        viewport.panBy(event->pos() - panOrigin);
+        panOrigin = event->pos();
+        update();
+        return;
+    }
+
+    if (selectionDrag != SelectionDrag::None && (event->buttons() & Qt::LeftButton))
+    {
+        selectionMove(mousePos2Px(event->pos()));
+    }
+    else if (strokeActive && (event->buttons() & Qt::LeftButton))
+    {
+        noteInput();
+
+        // Moves are buffered and drawn together once the queued events are handled
+        pendingStroke.append(mousePos2Px(event->pos()));
+        if (!strokeFlushQueued)
         {
-            pencil->draw(pt.x(), pt.y(), image, spriteSize);
+            strokeFlushQueued = true;
+            QTimer::singleShot(0, this, &Sprite::flushStroke);
         }
-        else
+    }
+}
+
+void Sprite::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (panning && event->button() == Qt::MiddleButton)
+    {
+        panning = false;
+        unsetCursor();
+        return;
+    }
+
+    if (selectionDrag != SelectionDrag::None && event->button() == Qt::LeftButton)
+    {
+        selectionRelease();
+    }
+    else if (strokeActive && event->button() == Qt::LeftButton)
+    {
+        strokeActive = false;
+        flushStroke();
+        history.endStroke(activeImage(), strokeRect, activeLayer);
+        strokeRect = QRect();
+    }
+}
+
+void Sprite::flushStroke()
+{
+    strokeFlushQueued = false;
+    if (pendingStroke.isEmpty() || !pencil)
+    {
+        return;
+    }
+    Diagnostics::Scope scope("stroke", "canvas");
+
+    // Continue from the last drawn point so consecutive batches stay connected
+    pendingStroke.prepend(lastStrokePoint);
+    lastStrokePoint = pendingStroke.last();
+
+    // Each tile is saved for undo just before the brush first reaches it
+    QRect changed = pencil->stroke(pendingStroke, activeImage(), [this](const TileSet &tiles) {
+        history.captureTiles(activeImage(), tiles);
+    });
+    pendingStroke.clear();
+    strokeRect |= changed;
+    markDirty(changed);
+}
+
+void Sprite::selectionPress(const QPoint &pixel)
+{
+    selectionAnchor = pixel;
+    if (isSelected(pixel))
+    {
+        // Lifting and dropping the pixels are recorded together as one undo entry
+        history.beginTiledStroke(activeImage().size());
+        floating = liftSelection();
+        floatingPos = selection.topLeft();
+        selectionDrag = SelectionDrag::Move;
+    }
+    else if (pencil->getLassoMode())
+    {
+        clearSelection();
+        selectionOutline = {pixel};
+        selectionDrag = SelectionDrag::Lasso;
+    }
+    else
+    {
+        selectRect(QRect(pixel, pixel));
+        selectionDrag = SelectionDrag::Rectangle;
+    }
+}
+
+void Sprite::selectionMove(const QPoint &pixel)
+{
+    switch (selectionDrag)
+    {
+    case SelectionDrag::Rectangle:
+        selectRect(QRect(selectionAnchor, pixel));
+        break;
+    case SelectionDrag::Lasso:
+        if (selectionOutline.isEmpty() || selectionOutline.last() != pixel)
         {
-            pencil->erase(pt.x(), pt.y(), image, spriteSize);
+            selectionOutline << pixel;
+            update();
         }
+        break;
+    case SelectionDrag::Move:
+        floatingPos = selection.topLeft() + pixel - selectionAnchor;
         update();
+        break;
+    case SelectionDrag::None:
+        break;
+    }
+}
+
+void Sprite::selectionRelease()
+{
+    const SelectionDrag drag = selectionDrag;
+    selectionDrag = SelectionDrag::None;
+
+    if (drag == SelectionDrag::Lasso)
+    {
+        selectLasso(selectionOutline);
+    }
+    else if (drag == SelectionDrag::Rectangle && selection.width() == 1 && selection.height() == 1)
+    {
+        clearSelection();   // A click without dragging deselects
+    }
+    else if (drag == SelectionDrag::Move)
+    {
+        const QRect source = selection;
+        dropSelection(floating, selectionMask, selectionOutline.translated(floatingPos - source.topLeft()), floatingPos);
+        history.endStroke(activeImage(), source | QRect(floatingPos, floating.size()), activeLayer);
+        floating = QImage();
+    }
+}
+
+void Sprite::selectLasso(const QPolygon &outline)
+{
+    const QRect bounds = outline.boundingRect().intersected(QRect(0, 0, spriteSize, spriteSize));
+    if (outline.size() < 3 || bounds.isEmpty())
+    {
+        clearSelection();
+        return;
+    }
+
+    // The outline runs through pixel centers, and pixels it passes over are selected too
+    QPolygonF centers;
+    for (const QPoint &point : outline)
+    {
+        centers << QPointF(point) + QPointF(0.5, 0.5);
+    }
+
+    QImage mask(bounds.size(), QImage::Format_Alpha8);
+    mask.fill(0);
+    QPainter painter(&mask);
+    painter.translate(-bounds.topLeft());
+    painter.setPen(QPen(Qt::black, 1));
+    painter.setBrush(Qt::black);
+    painter.drawPolygon(centers);
+    painter.end();
+
+    selection = bounds;
+    selectionMask = mask;
+    selectionOutline = outline;
+    update();
+}
+
+bool Sprite::isSelected(const QPoint &pixel) const
+{
+    if (!selection.contains(pixel))
+    {
+        return false;
+    }
+    return selectionMask.isNull()
+           || selectionMask.constScanLine(pixel.y() - selection.top())[pixel.x() - selection.left()] != 0;
+}
+
+QImage Sprite::liftSelection()
+{
+    QImage &image = activeImage();
+    captureForUndo(selection);
+
+    QImage lifted(selection.size(), QImage::Format_ARGB32_Premultiplied);
+    lifted.fill(Qt::transparent);
+    PixelOps::blitMasked(lifted, image.copy(selection), selectionMask, QPoint(0, 0));
+    markDirty(PixelOps::clearMasked(image, selection, selectionMask));
+    return lifted;
+}
+
+void Sprite::dropSelection(const QImage &pixels, const QImage &mask, const QPolygon &outline, const QPoint &topLeft)
+{
+    const QRect target(topLeft, pixels.size());
+    captureForUndo(target);
+    markDirty(PixelOps::blitMasked(activeImage(), pixels, mask, topLeft));
+
+    // Whatever landed off the sprite is gone, the selection keeps only what is still on it
+    const QRect kept = target.intersected(QRect(0, 0, spriteSize, spriteSize));
+    selection = kept;
+    selectionMask = mask.isNull() || kept.isEmpty() ? QImage() : mask.copy(kept.translated(-topLeft));
+    selectionOutline = outline;
+    update();
+}
+
+void Sprite::transformSelection(const std::function<QImage(const QImage &)> &transform,
+                                const std::function<QPoint(const QPoint &, const QSize &)> &mapPoint)
+{
+    const bool wholeLayer = !hasSelection();
+    if (wholeLayer)
+    {
+        selectRect(QRect(0, 0, spriteSize, spriteSize));
+    }
+
+    const QRect source = selection;
+    history.beginTiledStroke(activeImage().size());
+    const QImage pixels = transform(liftSelection());
+    const QImage mask = selectionMask.isNull() ? QImage() : transform(selectionMask);
+
+    // The result is centered where the selection was
+    const QPoint topLeft(source.x() + (source.width() - pixels.width()) / 2,
+                         source.y() + (source.height() - pixels.height()) / 2);
+    QPolygon outline;
+    for (const QPoint &point : std::as_const(selectionOutline))
+    {
+        outline << topLeft + mapPoint(point - source.topLeft(), source.size());
+    }
+
+    dropSelection(pixels, mask, outline, topLeft);
+    history.endStroke(activeImage(), source | QRect(topLeft, pixels.size()), activeLayer);
+
+    if (wholeLayer)
+    {
+        clearSelection();
+    }
+}
+
+void Sprite::captureForUndo(const QRect &pixels)
+{
+    TileSet tiles(activeImage().size());
+    tiles.insert(pixels);
+    history.captureTiles(activeImage(), tiles);
+}
+
+void Sprite::paintSelection(QPainter &painter) const
+{
+    const bool moving = selectionDrag == SelectionDrag::Move;
+    if (moving && !floating.isNull())
+    {
+        painter.drawImage(viewport.pixelRectToWidget(QRect(floatingPos, floating.size())), floating);
+    }
+
+    const QPoint shift = moving ? floatingPos - selection.topLeft() : QPoint();
+    auto center = [this, shift](const QPoint &pixel) {
+        return viewport.pixelRectToWidget(QRect(pixel + shift, QSize(1, 1))).center();
+    };
+
+    QPolygon outline;
+    for (const QPoint &point : selectionOutline)
+    {
+        outline << center(point);
+    }
+    if (outline.isEmpty() && !hasSelection())
+    {
+        return;
+    }
+
+    // A dashed black line over a solid white one shows up on any color
+    painter.save();
+    painter.setBrush(Qt::NoBrush);
+    for (const QPen &pen : {QPen(Qt::white, 0), QPen(Qt::black, 0, Qt::DashLine)})
+    {
+        painter.setPen(pen);
+        if (selectionDrag == SelectionDrag::Lasso)
+        {
+            painter.drawPolyline(outline);
+        }
+        else if (!outline.isEmpty())
+        {
+            painter.drawPolygon(outline);
+        }
+        else
+        {
+            painter.drawRect(viewport.pixelRectToWidget(selection.translated(shift)));
+        }
+    }
+    painter.restore();
+}
+
+void Sprite::noteInput()
+{
+    // Latency is measured from the oldest input the screen has not caught up with yet
+    if (!inputPending && Diagnostics::isEnabled())
+    {
+        inputStart = Diagnostics::now();
+        inputPending = true;
     }
 }
 
 QPoint Sprite::mousePos2Px(QPoint pt)
 {
-    QSize labelSize = size();
-    int x = pt.x() * spriteSize / labelSize.width();    // Gets x value of position within frame
-    int y = pt.y() * spriteSize / labelSize.height();   // Gets y value of position within frame
-    return QPoint(x, y);
+    return viewport.widgetToPixel(pt);  // Follows the zoom and pan of the view
+}
+
+void Sprite::invalidateBacking()
+{
+    flattenDirty = TileSet(QSize(spriteSize, spriteSize));
+    flattenDirty.insert(QRect(0, 0, spriteSize, spriteSize));
+    viewport.setCanvasSize(spriteSize);
+    update();
+    bumpVersion();
+}
+
+void Sprite::bumpVersion()
+{
+    version = ++lastVersion;
+    emit spriteUpdated();
+}
+
+QImage &Sprite::activeImage()
+{
+    expand();
+    return layers[activeLayer].image;
+}
+
+const QImage &Sprite::activeImage() const
+{
+    Q_ASSERT(isLoaded() && activeLayer >= 0 && activeLayer < layers.size());
+    return layers[activeLayer].image;
 }
@@ -11,14 +11,25 @@
 #ifndef SPRITE_H
 #define SPRITE_H
 
+#include <QHash>
 #include <QImage>
 #include <QLabel>
 #include <QMouseEvent>
 #include <QObject>
 #include <QPainter>
-#include <QStack>
+#include <QPixmap>
+#include <QPolygon>
+#include <QSet>
+#include <QVector>
+#include <QWheelEvent>
+#include "canvasviewport.h"
+#include "colorpalette.h"
+#include "framestore.h"
+#include "layer.h"
 #include "pencil.h"
+#include "undohistory.h"
 #include <QApplication>
+#include <functional>
 
 /*
  * The Sprite class is defined as a subclass of the QLabel class for integration with QFrame
@@ -39,7 +50,8 @@ public:
     explicit Sprite(int size = 2, QWidget *parent = nullptr);
 
     /**
-     * @brief Sprite Copy constructor for Sprite.
+     * @brief Sprite Copy constructor for Sprite. The copy shares the pixels of the other Sprite until
+     * either of them is drawn on, which gives it a private copy.
      * @param other - The other Sprite from which to copy.
      */
     Sprite(const Sprite &other);
@@ -63,19 +75,188 @@ public:
     int getSpriteSize() const;
 
     /**
-     * @brief getImage Gets the entire image that the Sprite contains.
-     * @return A QImage representing the entire image that the sprite contained.
+     * @brief getImage Gets the entire image that the Sprite contains, with its visible layers
+     * flattened. Only regions changed since the last call are composited again, and only where a layer
+     * painted. A single opaque layer is returned as it is, without a composite. A compact sprite
+     * keeps no composite and flattens its layers anew on every call, so callers should cache the
+     * result by version.
+     * @return A premultiplied ARGB32 QImage representing the entire image of the sprite.
      */
-    const QImage &getImage() const;
+    QImage getImage() const;
 
     /**
-     * @brief setImage Sets the entire Sprite to a new image.
+     * @brief setImage Sets the entire Sprite to a new image, as a single layer.
      * @param image The image that will be set on the Sprite.
      */
     void setImage(const QImage &image);
 
     /**
-     * @brief getPixel Gets a particular pixel on the Sprite.
+     * @brief getLayers Gets every layer of the sprite, bottom layer first. Empty while the sprite is unloaded.
+     */
+    const QVector<Layer> &getLayers() const;
+
+    /**
+     * @brief setLayers Replaces every layer of the sprite. Clears the undo history.
+     * @param layers - the new layers, bottom layer first, all the same square size.
+     */
+    void setLayers(const QVector<Layer> &layers);
+
+    /**
+     * @brief compact Stores every layer as 8-bit indices into a palette, adding any colors the
+     * palette lacks, and drops the composite and cached canvas blocks. Pixels are unchanged, and
+     * the sprite expands itself again as soon as anything draws on it.
+     * @param palette - the palette shared by every frame of the project.
+     * @return True if the sprite is compact, false if its colors would not fit in the palette.
+     */
+    bool compact(ColorPalette &palette);
+
+    /**
+     * @brief expand Stores every layer as premultiplied ARGB32 again, ready for drawing.
+     */
+    void expand();
+
+    /**
+     * @brief isCompact Returns whether the layers are stored as 8-bit palette indices.
+     */
+    bool isCompact() const;
+
+    /**
+     * @brief setUnloaded Replaces the pixels with a frame that stays encoded until it is first needed. Clears
+     * the undo history.
+     * @param stored - where the encoded frame is kept.
+     * @param size - the side length of the frame.
+     */
+    void setUnloaded(const StoredFrame &stored, int size);
+
+    /**
+     * @brief setStoredFrame Records that an exact copy of the current pixels is stored, so the sprite can be
+     * unloaded without encoding them, and saved without decoding them.
+     * @param stored - where the encoded copy is kept.
+     */
+    void setStoredFrame(const StoredFrame &stored);
+
+    /**
+     * @brief getStoredFrame Gets where an exact copy of the current pixels is stored.
+     * @return The stored copy, or a null StoredFrame if the pixels changed since they were last stored.
+     */
+    StoredFrame getStoredFrame() const;
+
+    /**
+     * @brief load Decodes the pixels of an unloaded sprite. Drawing, undo and redo load the sprite by
+     * themselves. The version is unchanged, as the pixels are the same.
+     */
+    void load();
+
+    /**
+     * @brief unload Drops the layers, composite and cached canvas blocks, keeping the pixels encoded until
+     * they are needed again. Pixels changed since they were last stored are encoded first. The undo history
+     * is kept. While unloaded, getImage decodes the pixels on every call without keeping them.
+     * @return True if the sprite is unloaded, false if it holds a moved selection that cannot be stored.
+     */
+    bool unload();
+
+    /**
+     * @brief isLoaded Returns whether the layers of the sprite are in memory.
+     */
+    bool isLoaded() const;
+
+    /**
+     * @brief getContentHash Gets a hash of the pixels and settings of every layer, kept until the sprite
+     * changes. Identical sprites have the same hash, but sprites with the same hash may still differ.
+     * @return The hash, or 0 while the sprite is unloaded.
+     */
+    size_t getContentHash() const;
+
+    /**
+     * @brief hasSameContent Returns whether another loaded sprite has exactly the same layers.
+     * @param other - the sprite to compare with.
+     */
+    bool hasSameContent(const Sprite &other) const;
+
+    /**
+     * @brief shareLayers Makes the sprite hold its layers in the same memory as an identical sprite, until
+     * either of them is drawn on. The version and undo history are unchanged, as the pixels are the same.
+     * @param other - a sprite for which hasSameContent is true.
+     */
+    void shareLayers(const Sprite &other);
+
+    /**
+     * @brief setColorTable Recolors a compact sprite by giving its layers new palette colors, without
+     * touching their pixels. The undo history is recolored to match. Does nothing to a sprite that is not compact.
+     * @param colors - the non-premultiplied ARGB32 color of each palette index.
+     */
+    void setColorTable(const QVector<QRgb> &colors);
+
+    /**
+     * @brief recolorUnloaded Recolors an unloaded sprite without decoding it. The change is kept with the
+     * stored pixels and made to them whenever they are decoded. The undo history is recolored to match.
+     * @param from - the palette before the change, holding every color of the sprite.
+     * @param to - the palette after the change.
+     * @return True if the sprite was recolored, false if it is loaded or must be loaded to be recolored.
+     */
+    bool recolorUnloaded(const QVector<QRgb> &from, const QVector<QRgb> &to);
+
+    /**
+     * @brief getLayerCount Gets the number of layers in the sprite.
+     */
+    int getLayerCount() const;
+
+    /**
+     * @brief getActiveLayer Gets the index of the layer that tools draw on.
+     */
+    int getActiveLayer() const;
+
+    /**
+     * @brief setActiveLayer Chooses the layer that tools draw on.
+     * @param index - the index of the layer, 0 being the bottom layer.
+     */
+    void setActiveLayer(int index);
+
+    /**
+     * @brief addLayer Adds an empty layer directly above the active layer and makes it active.
+     * Clears the undo history.
+     * @param name - the name of the new layer.
+     * @return The index of the new layer.
+     */
+    int addLayer(const QString &name);
+
+    /**
+     * @brief removeLayer Removes a layer. The last remaining layer cannot be removed.
+     * Clears the undo history.
+     * @param index - the index of the layer to remove.
+     */
+    void removeLayer(int index);
+
+    /**
+     * @brief moveLayer Moves a layer to another position in the stack. Clears the undo history.
+     * @param from - the current index of the layer.
+     * @param to - the index the layer should end up at.
+     */
+    void moveLayer(int from, int to);
+
+    /**
+     * @brief setLayerVisible Shows or hides a layer.
+     * @param index - the index of the layer.
+     * @param visible - whether the layer is composited.
+     */
+    void setLayerVisible(int index, bool visible);
+
+    /**
+     * @brief setLayerOpacity Sets how opaque a layer is.
+     * @param index - the index of the layer.
+     * @param opacity - 0 for invisible to 255 for fully opaque.
+     */
+    void setLayerOpacity(int index, int opacity);
+
+    /**
+     * @brief setLayerBlendMode Sets how a layer combines with the layers below it.
+     * @param index - the index of the layer.
+     * @param mode - the blend mode.
+     */
+    void setLayerBlendMode(int index, BlendMode mode);
+
+    /**
+     * @brief getPixel Gets a particular pixel on the active layer.
      * @param x The x (width) position of the pixel.
      * @param y The y (height) position of the pixel.
      * @return returns the QColor value of a pixel
@@ -83,13 +264,135 @@ public:
     QColor getPixel(int x, int y) const;
 
     /**
-     * @brief setPixel Sets a particular pixel on the sprite.
+     * @brief setPixel Sets a particular pixel on the active layer. Call markDirty to show the change.
      * @param x - The x (width) position of the pixel.
      * @param y - The y (height) position of the pixel.
      * @param color - the QColor data of the pixel.
      */
     void setPixel(int x, int y, const QColor &color);
 
+    /**
+     * @brief constScanLine Gets a read-only row of raw premultiplied ARGB32 pixels of the active layer. Each row holds
+     * getSpriteSize() pixels. Unlike scanLine, it does not load or expand the sprite.
+     * @param y - The row to get.
+     * @return A pointer to the first pixel of the row, or nullptr if the sprite is unloaded or compact,
+     * or the row is outside it.
+     */
+    const QRgb *constScanLine(int y) const;
+
+    /**
+     * @brief scanLine Gets a writable row of raw premultiplied ARGB32 pixels of the active layer. Each row holds
+     * getSpriteSize() pixels. The caller is responsible for calling markDirty afterwards.
+     * @param y - The row to get.
+     * @return A pointer to the first pixel of the row.
+     */
+    QRgb *scanLine(int y);
+
+    /**
+     * @brief fill Sets every pixel of the active layer to one color.
+     * @param color - the non-premultiplied ARGB32 color to fill with.
+     */
+    void fill(QRgb color);
+
+    /**
+     * @brief fillRect Sets every pixel inside a rectangle to one color.
+     * @param rect - the rectangle to fill, clipped to the sprite.
+     * @param color - the non-premultiplied ARGB32 color to fill with.
+     * @return The rectangle of pixels that changed.
+     */
+    QRect fillRect(const QRect &rect, QRgb color);
+
+    /**
+     * @brief blit Copies an image onto the active layer, replacing the pixels underneath.
+     * @param source - the image to copy, converted to premultiplied ARGB32 if needed.
+     * @param topLeft - where the top left pixel of the image lands on the sprite.
+     * @return The rectangle of pixels that changed.
+     */
+    QRect blit(const QImage &source, const QPoint &topLeft);
+
+    /**
+     * @brief convertedImage Gets a copy of the flattened sprite in another pixel format.
+     * @param format - the format of the returned image.
+     * @return The converted image, shared with the sprite if no conversion was needed.
+     */
+    QImage convertedImage(QImage::Format format) const;
+
+    /**
+     * @brief floodFill Fills the region of same-colored pixels of the active layer around a pixel, recorded as a
+     * single undo entry.
+     * @param start - the pixel the fill starts from.
+     * @param color - the non-premultiplied ARGB32 color to fill with.
+     * @return The rectangle of pixels that changed.
+     */
+    QRect floodFill(const QPoint &start, QRgb color);
+
+    /**
+     * @brief replaceColor Replaces every pixel of one color across the whole active layer, recorded
+     * as a single undo entry.
+     * @param from - the non-premultiplied ARGB32 color to replace.
+     * @param to - the non-premultiplied ARGB32 color to write in its place.
+     * @return The rectangle of pixels that changed.
+     */
+    QRect replaceColor(QRgb from, QRgb to);
+
+    /**
+     * @brief hasSelection Returns whether any pixels are selected.
+     */
+    bool hasSelection() const;
+
+    /**
+     * @brief getSelection Gets the bounding rectangle of the selected pixels.
+     * @return The selection, or an empty rectangle if nothing is selected.
+     */
+    QRect getSelection() const;
+
+    /**
+     * @brief selectRect Selects a rectangle of pixels.
+     * @param rect - the rectangle to select, clipped to the sprite.
+     */
+    void selectRect(const QRect &rect);
+
+    /**
+     * @brief clearSelection Deselects every pixel.
+     */
+    void clearSelection();
+
+    /**
+     * @brief flipSelection Mirrors the selected pixels, or the whole active layer if nothing is
+     * selected, recorded as a single undo entry.
+     * @param orientation - Qt::Horizontal to mirror left to right, Qt::Vertical for top to bottom.
+     */
+    void flipSelection(Qt::Orientation orientation);
+
+    /**
+     * @brief rotateSelection Turns the selected pixels, or the whole active layer if nothing is
+     * selected, a quarter turn about their center, recorded as a single undo entry.
+     * @param clockwise - the direction to turn.
+     */
+    void rotateSelection(bool clockwise);
+
+    /**
+     * @brief scaleSelection Resizes the selected pixels, or the whole active layer if nothing is
+     * selected, about their center with nearest neighbour sampling, recorded as a single undo entry.
+     * @param factor - how much larger the result is, for example 2 or 0.5.
+     */
+    void scaleSelection(double factor);
+
+    /**
+     * @brief markDirty Redraws a region of the canvas after pixels of the active layer changed. Only
+     * the tiles of that region are composited again, and only the widget area covering it is rescaled
+     * and repainted.
+     * @param pixels - the rectangle of sprite pixels that changed.
+     */
+    void markDirty(const QRect &pixels);
+
+    /**
+     * @brief getVersion Gets a number that changes every time the pixels of the sprite change.
+     * Versions are unique across all sprites, so a cached version never matches a different sprite.
+     * @return The current version of the sprite's pixels.
+     */
+    quint64 getVersion() const;
+
     /**
      * @brief setPencil Sets the pencil to be used on the sprite.
      * @param pencil The pencil object.
@@ -118,15 +421,58 @@ public:
      */
     void setEyedropper(bool active);
 
+    /**
+     * @brief getUndoMemoryUsage Gets how many bytes the undo and redo history of the sprite holds.
+     */
+    qsizetype getUndoMemoryUsage() const;
+
+    /**
+     * @brief getMemoryUsage Gets how many bytes of pixels the sprite holds, counting its layers, its
+     * composite and its undo history.
+     */
+    qsizetype getMemoryUsage() const;
+
+    /**
+     * @brief getMemoryUsage Gets how many bytes of pixels the sprite holds that no sprite counted before it
+     * shares, so that pixels shared by several sprites are only counted once.
+     * @param counted - the cache keys of the images counted so far, to which those of this sprite are added.
+     */
+    qsizetype getMemoryUsage(QSet<qint64> &counted) const;
+
+    /**
+     * @brief setUndoMemoryBudget Sets how many bytes of undo/redo history the sprite may keep.
+     * Once exceeded, the oldest strokes are forgotten first.
+     * @param bytes - the memory budget of the history.
+     */
+    void setUndoMemoryBudget(qsizetype bytes);
+
+    /**
+     * @brief setUnderlay Sets an image shown beneath the sprite without becoming part of it, such
+     * as the neighbouring frames when onion skinning.
+     * @param underlay - a premultiplied ARGB32 image the size of the sprite, or a null image for none.
+     */
+    void setUnderlay(const QImage &underlay);
+
+    /**
+     * @brief getView Gets the zoom and pan of the canvas.
+     */
+    CanvasViewport::View getView() const;
+
+    /**
+     * @brief setView Sets the zoom and pan of the canvas, so another frame can be shown the same way.
+     * @param view - a view returned by getView.
+     */
+    void setView(const CanvasViewport::View &view);
+
 public slots:
 
     /**
-     * @brief pops a frame from the undo stack to set as the current image.
+     * @brief reverts the most recent stroke on the current image.
      */
     void undoPaint();
 
     /**
-     * @brief pops a frame from the redo stack to set as the current image.
+     * @brief reapplies the most recently undone stroke on the current image.
      */
     void redoPaint();
 
@@ -135,21 +481,164 @@ private:
     // The stored mouse position in relaton to the sprite.
     QPoint mousePos2Px(QPoint pt);
 
-    // The entire image that represents the sprite.
-    QImage image;
+    // Starts timing the latency of a mouse event that should change pixels, unless one is already waiting.
+    void noteInput();
+
+    // Composites and repaints regions of the sprite, then announces the change once.
+    void recomposite(const QVector<QRect> &regions);
+
+    // Which drag of the selection tool is in progress.
+    enum class SelectionDrag
+    {
+        None,
+        Rectangle,
+        Lasso,
+        Move
+    };
+
+    // Starts selecting, or starts moving the selection if the press is inside it.
+    void selectionPress(const QPoint &pixel);
+
+    // Follows the mouse while selecting or moving.
+    void selectionMove(const QPoint &pixel);
+
+    // Finishes selecting or drops the moved pixels.
+    void selectionRelease();
+
+    // Selects the pixels inside a freehand outline.
+    void selectLasso(const QPolygon &outline);
 
-    // The stack that holds QImages for the undo button functionality.
-    QStack<QImage> undoStack;
+    // Returns whether a pixel is selected.
+    bool isSelected(const QPoint &pixel) const;
 
-    // The stack that holds QImages for the redo button functionality.
-    QStack<QImage> redoStack;
+    // Takes the selected pixels off the active layer, leaving them transparent.
+    QImage liftSelection();
+
+    // Pastes pixels onto the active layer where their mask is set and makes them the selection.
+    void dropSelection(const QImage &pixels, const QImage &mask, const QPolygon &outline, const QPoint &topLeft);
+
+    // Lifts the selection, or the whole active layer, transforms it and drops it centered where it was.
+    void transformSelection(const std::function<QImage(const QImage &)> &transform,
+                            const std::function<QPoint(const QPoint &, const QSize &)> &mapPoint);
+
+    // Saves the tiles of the active layer covering some pixels for the undo entry being recorded.
+    void captureForUndo(const QRect &pixels);
+
+    // Draws the moved pixels and the outline of the selection.
+    void paintSelection(QPainter &painter) const;
+
+    // Drops the cached scaled blocks and repaints the whole widget.
+    void invalidateBacking();
+
+    // Gives the sprite a new version and announces the change.
+    void bumpVersion();
+
+    // The premultiplied colors that change between two palettes, old color to new, for recoloring the undo history.
+    static QHash<QRgb, QRgb> premultipliedChanges(const QVector<QRgb> &from, const QVector<QRgb> &to);
+
+    // Rasterizes the buffered stroke points onto the image in a single pass.
+    void flushStroke();
+
+    // The pixels of the layer that tools draw on, expanding a compact sprite first.
+    QImage &activeImage();
+
+    // The pixels of the layer that tools draw on, as they are stored. The sprite must be loaded, and the
+    // layer is 8-bit while the sprite is compact.
+    const QImage &activeImage() const;
+
+    // The layers of the sprite, bottom layer first.
+    QVector<Layer> layers;
+
+    // The index of the layer that tools draw on.
+    int activeLayer = 0;
+
+    // The visible layers composited together, premultiplied. Null while the sprite is compact.
+    mutable QImage flattened;
+
+    // The tiles of the composite that are out of date.
+    mutable TileSet flattenDirty;
+
+    // The tiles of the composite that may hold pixels, the rest are still blank.
+    mutable TileSet flattenPainted;
+
+    // The zoom and pan of the canvas, with the scaled blocks of the sprite it has drawn.
+    CanvasViewport viewport;
+
+    // Drawn beneath the sprite, blended into the scaled blocks of the viewport.
+    QImage underlay;
+
+    // True while the middle button drags the view.
+    bool panning = false;
+
+    // The last mouse position of the pan in progress.
+    QPoint panOrigin;
+
+    // Wheel movement not yet added up to a whole zoom step.
+    int wheelRemainder = 0;
+
+    // The bounding rectangle of the selected pixels, always inside the sprite.
+    QRect selection;
+
+    // For lasso selections, 255 where a pixel of the selection rectangle is selected. Null for rectangles.
+    QImage selectionMask;
+
+    // For lasso selections, the outline drawn around them, in sprite pixels.
+    QPolygon selectionOutline;
+
+    // The drag of the selection tool in progress.
+    SelectionDrag selectionDrag = SelectionDrag::None;
+
+    // The pixel where the drag of the selection tool started.
+    QPoint selectionAnchor;
+
+    // The selected pixels while they are being moved, and where their top left corner is.
+    QImage floating;
+    QPoint floatingPos;
+
+    // The per-stroke deltas for the undo and redo button functionality.
+    UndoHistory history;
+
+    // The pixels changed by the stroke in progress.
+    QRect strokeRect;
+
+    // Mouse positions of the stroke in progress that have not been drawn yet.
+    QVector<QPoint> pendingStroke;
+
+    // The last position of the stroke in progress that has been drawn.
+    QPoint lastStrokePoint;
+
+    // When the oldest mouse event not yet shown on screen was handled, for the diagnostics overlay.
+    qint64 inputStart = 0;
+
+    // True while a handled mouse event is waiting for the paint that shows its pixels.
+    bool inputPending = false;
+
+    // True between the press and release of a pencil or eraser stroke.
+    bool strokeActive = false;
+
+    // True while a flush of the pending stroke points is queued.
+    bool strokeFlushQueued = false;
 
     // A reference to the pencil object used in sprite manipulation.
-    Pencil *pencil;
+    Pencil *pencil = nullptr;
 
     // The size of the sprite represented by it's side lengths.
     int spriteSize;
 
+    // Bumped from a shared counter whenever the pixels change.
+    quint64 version;
+
+    // Where the pixels are kept encoded while the sprite is unloaded.
+    StoredFrame stored;
+
+    // The version whose pixels are stored, or 0 if there is no stored copy.
+    quint64 storedVersion = 0;
+
+    // The content hash of the layers, and the version and storage it was worked out for.
+    mutable size_t contentHash = 0;
+    mutable quint64 contentHashVersion = 0;
+    mutable bool contentHashCompact = false;
+
     // The width of the frame in the UI.
     int frameWidth;
 
@@ -180,6 +669,30 @@ protected:
      */
     void mouseMoveEvent(QMouseEvent *event) override;
 
+    /**
+     * @brief represents the user releasing the mouse, which ends the current stroke.
+     * @param event - the update of the mouse button being released.
+     */
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief fits the sprite to the canvas again on a middle button double click.
+     * @param event - the double click.
+     */
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief zooms the canvas in or out around the mouse position.
+     * @param event - the wheel movement.
+     */
+    void wheelEvent(QWheelEvent *event) override;
+
+    /**
+     * @brief keeps the view fitted to the new widget size.
+     * @param event - the new size.
+     */
+    void resizeEvent(QResizeEvent *event) override;
+
 signals:
 
     /**
@@ -189,7 +702,7 @@ signals:
     void changeColor(const QColor &color);
 
     /**
-     * @brief signals the sprite data has been updated.
+     * @brief signals the sprite's pixels have changed.
      */
     void spriteUpdated();
 
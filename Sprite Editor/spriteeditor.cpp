@@ -14,15 +14,32 @@ SpriteEditor::SpriteEditor(SpriteModel *model, QWidget *parent)
     , ui(new Ui::SpriteEditor)
     , model(model)
     , pencil(new Pencil())
+    , thumbnails(new ThumbnailCache(model, QSize(75, 75), this))
 {
-    animationTimer = new QTimer(this);
-    animationTimer->start(200);  // milliseconds
+    animationScheduler = new FrameScheduler(this);
+    animationScheduler->setFrameCount(model->getFrameCount());
     QShortcut *copyShortcut = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_C), this);
     QShortcut *pasteShortcut = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_V), this);
     QShortcut *undoShortcut = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_Z), this);
     QShortcut *redoShortcut = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_Y), this);
     ui->setupUi(this);
 
+    // A single label is reused for every preview frame
+    animationLabel = new QLabel(ui->animationPreviewBox);
+    animationLabel->setGeometry(ui->animationPreviewBox->rect());
+    previewCache.setTargetSize(animationLabel->size());
+
+    // The overlay sits over the canvas without taking its mouse events
+    diagnosticsOverlay = new QLabel(ui->drawingFrame);
+    diagnosticsOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+    diagnosticsOverlay->setStyleSheet("QLabel { background: rgba(0, 0, 0, 160); color: white; padding: 4px; }");
+    diagnosticsOverlay->move(4, 4);
+    diagnosticsOverlay->hide();
+    diagnosticsTimer.setInterval(500);
+
+    // A loaded project autosaves next to its file, a new one to a file of its own in the application data
+    autosave = new Autosave(model, Autosave::fileNameFor(model->getFileName()), this);
+
     // View -> Model
     connect(ui->returnToMenu,
             &QPushButton::clicked,
@@ -42,6 +59,10 @@ SpriteEditor::SpriteEditor(SpriteModel *model, QWidget *parent)
             &QToolButton::clicked,
             this,
             &SpriteEditor::saveProject);
+    connect(ui->exportButton,
+            &QToolButton::clicked,
+            this,
+            &SpriteEditor::exportAnimation);
     connect(ui->redValueSelector,
             &QSlider::valueChanged,
             this,
@@ -78,6 +99,18 @@ SpriteEditor::SpriteEditor(SpriteModel *model, QWidget *parent)
             &QPushButton::clicked,
             this,
             &SpriteEditor::eraserSelected);
+    connect(ui->bucketTool,
+            &QToolButton::clicked,
+            this,
+            &SpriteEditor::bucketSelected);
+    connect(ui->brushShape,
+            &QComboBox::currentIndexChanged,
+            this,
+            &SpriteEditor::brushShapeChanged);
+    connect(ui->mirrorMode,
+            &QComboBox::currentIndexChanged,
+            this,
+            &SpriteEditor::mirrorModeChanged);
     connect(ui->penSize,
             &QSlider::valueChanged,
             this,
@@ -98,6 +131,102 @@ SpriteEditor::SpriteEditor(SpriteModel *model, QWidget *parent)
             &QPushButton::toggled,
             this,
             &SpriteEditor::eyedropperToggled);
+    connect(ui->addLayer,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleAddLayer);
+    connect(ui->deleteLayer,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleDeleteLayer);
+    connect(ui->layerUp,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleLayerUp);
+    connect(ui->layerDown,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleLayerDown);
+    connect(ui->layerList,
+            &QListWidget::currentRowChanged,
+            this,
+            &SpriteEditor::layerSelected);
+    connect(ui->layerList,
+            &QListWidget::itemChanged,
+            this,
+            &SpriteEditor::layerItemChanged);
+    connect(ui->layerOpacity,
+            &QSlider::valueChanged,
+            this,
+            &SpriteEditor::layerOpacityChanged);
+    connect(ui->layerBlendMode,
+            &QComboBox::currentIndexChanged,
+            this,
+            &SpriteEditor::layerBlendModeChanged);
+    connect(ui->selectTool,
+            &QToolButton::clicked,
+            this,
+            &SpriteEditor::selectToolSelected);
+    connect(ui->lassoTool,
+            &QToolButton::clicked,
+            this,
+            &SpriteEditor::lassoToolSelected);
+    connect(ui->flipHorizontal,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleFlipHorizontal);
+    connect(ui->flipVertical,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleFlipVertical);
+    connect(ui->rotateClockwise,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleRotateClockwise);
+    connect(ui->rotateCounterClockwise,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleRotateCounterClockwise);
+    connect(ui->scaleUp,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleScaleUp);
+    connect(ui->scaleDown,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleScaleDown);
+    connect(ui->deselect,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleDeselect);
+    connect(ui->onionSkinFrames,
+            &QSpinBox::valueChanged,
+            this,
+            &SpriteEditor::onionSkinDepthChanged);
+    connect(ui->indexedMode,
+            &QCheckBox::toggled,
+            this,
+            &SpriteEditor::indexedModeToggled);
+    connect(ui->paletteList,
+            &QListWidget::itemDoubleClicked,
+            this,
+            &SpriteEditor::paletteColorPicked);
+    connect(ui->replacePaletteColor,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleReplacePaletteColor);
+    connect(ui->diagnosticsEnabled,
+            &QCheckBox::toggled,
+            this,
+            &SpriteEditor::diagnosticsToggled);
+    connect(ui->exportTrace,
+            &QPushButton::clicked,
+            this,
+            &SpriteEditor::handleExportTrace);
+    connect(&diagnosticsTimer,
+            &QTimer::timeout,
+            this,
+            &SpriteEditor::refreshDiagnostics);
 
     // Model -> View
     connect(model,
@@ -108,10 +237,32 @@ SpriteEditor::SpriteEditor(SpriteModel *model, QWidget *parent)
             &SpriteModel::displaySprite,
             this,
             &SpriteEditor::frameFocus);
+    connect(thumbnails,
+            &ThumbnailCache::thumbnailReady,
+            this,
+            &SpriteEditor::setFrameIcon);
+    connect(autosave,
+            &Autosave::saved,
+            this,
+            [this](const QString &fileName)
+            {
+                ui->statusbar->showMessage(tr("Autosaved to %1").arg(fileName), 3000);
+            });
+    connect(model,
+            &SpriteModel::paletteChanged,
+            this,
+            &SpriteEditor::refreshPaletteList);
     connect(model,
             &SpriteModel::disableDeleteButton,
             ui->deleteFrame,
             &QPushButton::setDisabled);
+    connect(model,
+            &SpriteModel::saveProgress,
+            this,
+            [this](int framesDone, int frameCount)
+            {
+                ui->statusbar->showMessage(QString("Saved frame %1 of %2").arg(framesDone).arg(frameCount), 2000);
+            });
     connect(model->getFrame(currentFrameIndex),
             &Sprite::disableDropper,
             this,
@@ -145,11 +296,11 @@ SpriteEditor::SpriteEditor(SpriteModel *model, QWidget *parent)
             this,
             &SpriteEditor::handleRedo);
 
-    // Animation timer
-    connect(animationTimer,
-            &QTimer::timeout,
+    // Animation scheduler
+    connect(animationScheduler,
+            &FrameScheduler::frameChanged,
             this,
-            &SpriteEditor::nextAnimationFrame);
+            &SpriteEditor::showAnimationFrame);
 
     Sprite *frame = model->getFrame(currentFrameIndex);
     if (frame)
@@ -167,8 +318,7 @@ SpriteEditor::SpriteEditor(SpriteModel *model, QWidget *parent)
     // default to 1 FPS (1-120 limit)
     ui->fpsSelector->setValue(1);
 
-    // 1 FPS = 1000 ms per frame
-    animationTimer->start(1000);
+    animationScheduler->start();
 
     // set the range for each color selector to 0 - 255
     ui->redValueSelector->setRange(0, 255);
@@ -211,13 +361,27 @@ SpriteEditor::SpriteEditor(SpriteModel *model, QWidget *parent)
     ui->frameDisplay->addItem(item);
     frameFocus(model->getFrame(0));
     ui->deleteFrame->setDisabled(true);
+    updateFrameIcons();
+
+    // A loaded project may already be indexed
+    const QSignalBlocker indexedBlocker(ui->indexedMode);
+    ui->indexedMode->setChecked(model->isIndexedMode());
+    refreshPaletteList();
 }
 
 SpriteEditor::~SpriteEditor()
 {
     delete ui;
     delete pencil;
-    delete animationTimer;
+}
+
+void SpriteEditor::closeEvent(QCloseEvent *event)
+{
+    // A closed editor is kept alive, so nothing it started may keep running behind the next one
+    autosave->stop();
+    animationScheduler->stop();
+    diagnosticsTimer.stop();
+    QMainWindow::closeEvent(event);
 }
 
 void SpriteEditor::backToMainMenu()
@@ -236,29 +400,57 @@ void SpriteEditor::saveProject()
     if (!fileName.isEmpty())
     {
         model->saveProject(fileName);
+
+        // Later autosaves go next to the project, as name.autosave.ssp
+        autosave->setFileName(Autosave::fileNameFor(fileName));
     }
 }
 
+void SpriteEditor::exportAnimation()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    tr("Export Animation"),
+                                                    "",
+                                                    tr("Sprite Sheet (*.png);;Animated GIF (*.gif);;Animated PNG (*.apng)"));
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    ui->statusbar->showMessage(tr("Exporting..."));
+    bool exported = model->exportAnimation(fileName, ui->fpsSelector->value());
+    ui->statusbar->showMessage(exported ? tr("Exported %1").arg(fileName) : tr("Export failed"), 3000);
+}
+
 void SpriteEditor::toggleAnimation()
 {
-    if (animationTimer->isActive())
-        animationTimer->stop();
+    if (animationScheduler->isActive())
+        animationScheduler->stop();
     else
-        animationTimer->start();
+        animationScheduler->start();
 }
 
-void SpriteEditor::nextAnimationFrame()
+void SpriteEditor::showAnimationFrame(int frameIndex)
 {
     int frameCount = model->getFrameCount();
+    animationScheduler->setFrameCount(frameCount);   // frames may have been added or deleted
     if (frameCount == 0)
         return;
-    if (currentAnimationFrameIndex > frameCount - 1)
-        currentAnimationFrameIndex = 0;
-    Sprite *sprite = model->getFrame(currentAnimationFrameIndex);
-    QWidget *box = ui->animationPreviewBox;
-    showImg(sprite->getImage(), box);
-    currentAnimationFrameIndex++;
-    currentAnimationFrameIndex %= frameCount;
+    if (frameIndex > frameCount - 1)
+        frameIndex = animationScheduler->getCurrentFrame();
+    if (frameIndex == 0)
+    {
+        // once per loop, forget the pixmaps of deleted frames and report the measured pacing
+        QVector<Sprite *> frames;
+        for (int i = 0; i < frameCount; i++)
+            frames.append(model->getFrame(i));
+        previewCache.retain(frames);
+        ui->fpsLabel->setToolTip(QString("Measured: %1 FPS, %2 dropped frames")
+                                     .arg(animationScheduler->getMeasuredFps(), 0, 'f', 1)
+                                     .arg(animationScheduler->getDroppedFrames()));
+    }
+    Sprite *sprite = model->getFrame(frameIndex);
+    animationLabel->setPixmap(previewCache.pixmap(sprite));
 }
 
 void SpriteEditor::updateFPS(int fps)
@@ -269,28 +461,10 @@ void SpriteEditor::updateFPS(int fps)
         fps = 1;
         ui->fpsSelector->setValue(1);
     }
-    int interval = 1000 / fps; // calculate interval in milliseconds.
-    animationTimer->setInterval(interval);
+    animationScheduler->setFps(fps);
     ui->fpsLabel->setText(QString("FPS: %1").arg(fps));
 }
 
-void SpriteEditor::showImg(QImage img, QWidget *box)
-{
-    std::string tag = "animationCycle";
-    for (QLabel *label : box->findChildren<QLabel *>(tag))
-    {
-        delete label;
-    }
-    QLabel *label = new QLabel(box);
-    label->setObjectName(tag);
-    label->setGeometry(box->rect());
-    label->setPixmap(
-        QPixmap::fromImage(img).scaled(label->size(),
-        Qt::KeepAspectRatio,
-        Qt::FastTransformation));
-    label->show();
-}
-
 void SpriteEditor::updateColorSelector(const QColor &color)
 {
     ui->redValueSelector->setValue(color.red());
@@ -347,19 +521,24 @@ void SpriteEditor::updateFrameIcons()
         ui->frameDisplay->addItem(item);
     }
 
-    // Update all icons to reflect frames
-    for (int i = 0; i < model->getFrameCount(); i++)
+    // Icons of changed frames are rescaled in the background and arrive in setFrameIcon
+    thumbnails->scheduleUpdate();
+    refreshOnionSkin();
+}
+
+void SpriteEditor::setFrameIcon(int frameIndex, const QImage &icon)
+{
+    QListWidgetItem *item = ui->frameDisplay->item(frameIndex);
+    if (!item)
+        return;
+
+    if (!icon.isNull())
     {
-        QImage img = model->getFrame(i)->getImage();
-        if (!img.isNull())
-        {
-            QImage updatedIcon = img.scaled(75, 75, Qt::KeepAspectRatio, Qt::FastTransformation);
-            ui->frameDisplay->item(i)->setIcon(QIcon(QPixmap::fromImage(updatedIcon)));
-        }
-        else
-        {
-            qWarning() << "Null image detected in frame" << i;
-        }
+        item->setIcon(QIcon(QPixmap::fromImage(icon)));
+    }
+    else
+    {
+        qWarning() << "Null image detected in frame" << frameIndex;
     }
 }
 
@@ -376,16 +555,26 @@ void SpriteEditor::frameFocus(Sprite *sprite)
 {
     if (!sprite)
         return;
+    model->focusFrame(sprite);
+    // Unique connections, a frame is focused again every time the user switches back to it
     connect(sprite,
             &Sprite::spriteUpdated,
-            this,
-            [this]() { updateFrameIcons(); });
+            thumbnails,
+            &ThumbnailCache::scheduleUpdate,
+            Qt::UniqueConnection);
     connect(sprite,
             &Sprite::disableDropper,
             this,
-            [this](){ ui->eyedropperTool->setChecked(false);});
+            &SpriteEditor::dropperFinished,
+            Qt::UniqueConnection);
+    // The newly focused frame is shown with the zoom and pan of the one it replaces
+    CanvasViewport::View view;
     for (int i = 0; i < model->getFrameCount(); i++)
     {
+        if (model->getFrame(i)->isVisible() && model->getFrame(i) != sprite)
+        {
+            view = model->getFrame(i)->getView();
+        }
         model->getFrame(i)->setMouseTracking(false);
         model->getFrame(i)->hide();
         model->getFrame(i)->setQFrame(nullptr);
@@ -393,9 +582,289 @@ void SpriteEditor::frameFocus(Sprite *sprite)
     sprite->setQFrame(ui->drawingFrame);
     sprite->setPencil(pencil);
     sprite->setGeometry(ui->drawingFrame->rect());
+    sprite->setView(view);
     sprite->setMouseTracking(true);
     sprite->show();
     currentDrawingSprite = sprite;
+    diagnosticsOverlay->raise();    // Kept above the newly shown frame
+    refreshLayerList();
+    refreshOnionSkin();
+}
+
+void SpriteEditor::refreshOnionSkin()
+{
+    QVector<Sprite *> frames;
+    for (int i = 0; i < model->getFrameCount(); i++)
+    {
+        frames.append(model->getFrame(i));
+    }
+
+    // Only a change to one of the neighbours blends them again, edits to the current frame never do
+    onionSkin.update(frames, int(frames.indexOf(currentDrawingSprite)));
+    currentDrawingSprite->setUnderlay(onionSkin.getUnderlay());
+    for (Sprite *frame : std::as_const(frames))
+    {
+        if (frame != currentDrawingSprite)
+        {
+            frame->setUnderlay(QImage());
+        }
+    }
+}
+
+void SpriteEditor::onionSkinDepthChanged(int frames)
+{
+    onionSkin.setDepth(frames);
+    refreshOnionSkin();
+}
+
+void SpriteEditor::indexedModeToggled(bool indexed)
+{
+    model->setIndexedMode(indexed);
+    refreshPaletteList();
+}
+
+void SpriteEditor::paletteColorPicked(QListWidgetItem *item)
+{
+    updateColorSelector(QColor::fromRgba(model->getPalette().getColors().value(ui->paletteList->row(item))));
+}
+
+void SpriteEditor::handleReplacePaletteColor()
+{
+    const int index = ui->paletteList->currentRow();
+    if (index < 0)
+    {
+        ui->statusbar->showMessage(tr("Select a palette color to replace"), 3000);
+        return;
+    }
+
+    model->setPaletteColor(index, pencil->getColor().rgba());
+    ui->paletteList->setCurrentRow(index);
+}
+
+void SpriteEditor::refreshPaletteList()
+{
+    ui->paletteList->clear();
+    const QVector<QRgb> &colors = model->getPalette().getColors();
+    for (int i = 0; i < colors.size(); i++)
+    {
+        QPixmap swatch(ui->paletteList->iconSize());
+        swatch.fill(QColor::fromRgba(colors[i]));
+        QListWidgetItem *item = new QListWidgetItem(QIcon(swatch), QString());
+        item->setToolTip(QString("%1: #%2").arg(i).arg(colors[i], 8, 16, QChar('0')));
+        ui->paletteList->addItem(item);
+    }
+    ui->replacePaletteColor->setEnabled(model->isIndexedMode() && !colors.isEmpty());
+}
+
+void SpriteEditor::diagnosticsToggled(bool enabled)
+{
+    Diagnostics::setEnabled(enabled);
+    diagnosticsOverlay->setVisible(enabled);
+    if (enabled)
+    {
+        diagnosticsTimer.start();
+        refreshDiagnostics();
+    }
+    else
+    {
+        diagnosticsTimer.stop();
+    }
+}
+
+void SpriteEditor::handleExportTrace()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    tr("Export Trace"),
+                                                    "",
+                                                    tr("Chrome Trace (*.json)"));
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    if (!Diagnostics::exportTrace(fileName))
+    {
+        ui->statusbar->showMessage(tr("Could not export the trace"), 3000);
+    }
+}
+
+void SpriteEditor::refreshDiagnostics()
+{
+    // Memory is sampled here rather than on every edit, so the trace shows it as a steady series
+    const qsizetype frameBytes = model->getMemoryUsage();
+    Diagnostics::counter("frame memory", "bytes", frameBytes);
+
+    // One event per sample whatever the frame count, so counters never crowd the timings out of the log
+    qsizetype undoBytes = 0;
+    for (int i = 0; i < model->getFrameCount(); i++)
+    {
+        undoBytes += model->getFrame(i)->getUndoMemoryUsage();
+    }
+    const qsizetype editedUndoBytes = currentDrawingSprite ? currentDrawingSprite->getUndoMemoryUsage() : 0;
+    Diagnostics::counter("undo memory", {{"total", undoBytes}, {"edited frame", editedUndoBytes}});
+
+    auto timing = [](const char *name, const QString &label)
+    {
+        const Diagnostics::Stats stats = Diagnostics::getStats(name);
+        return QString("%1: %2 ms (avg %3, max %4)")
+            .arg(label)
+            .arg(stats.lastMs, 0, 'f', 2)
+            .arg(stats.averageMs, 0, 'f', 2)
+            .arg(stats.maxMs, 0, 'f', 2);
+    };
+
+    QStringList lines;
+    lines << timing("paint", tr("Paint"))
+          << timing("input to pixel", tr("Input to pixel"))
+          << timing("stroke", tr("Stroke"))
+          << timing("thumbnails", tr("Thumbnails"))
+          << tr("Frame memory: %1 KiB").arg(frameBytes / 1024)
+          << tr("Undo memory: %1 KiB").arg(editedUndoBytes / 1024);
+    diagnosticsOverlay->setText(lines.join('\n'));
+    diagnosticsOverlay->adjustSize();
+}
+
+void SpriteEditor::refreshLayerList()
+{
+    Sprite *sprite = currentDrawingSprite;
+    const QSignalBlocker listBlocker(ui->layerList);
+    const QSignalBlocker opacityBlocker(ui->layerOpacity);
+    const QSignalBlocker blendBlocker(ui->layerBlendMode);
+
+    // The top layer is listed first, like it is drawn
+    ui->layerList->clear();
+    const QVector<Layer> &layers = sprite->getLayers();
+    for (int i = int(layers.size()) - 1; i >= 0; i--)
+    {
+        QListWidgetItem *item = new QListWidgetItem(layers[i].name);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(layers[i].visible ? Qt::Checked : Qt::Unchecked);
+        ui->layerList->addItem(item);
+    }
+
+    const Layer &active = layers[sprite->getActiveLayer()];
+    ui->layerList->setCurrentRow(int(layers.size()) - 1 - sprite->getActiveLayer());
+    ui->layerOpacity->setValue(active.opacity);
+    ui->layerOpacityLabel->setText(QString("Opacity: %1").arg(active.opacity));
+    ui->layerBlendMode->setCurrentIndex(int(active.blendMode));
+    ui->deleteLayer->setEnabled(layers.size() > 1);
+}
+
+void SpriteEditor::handleAddLayer()
+{
+    Sprite *sprite = currentDrawingSprite;
+    sprite->addLayer(QString("Layer %1").arg(sprite->getLayerCount() + 1));
+    refreshLayerList();
+}
+
+void SpriteEditor::handleDeleteLayer()
+{
+    Sprite *sprite = currentDrawingSprite;
+    sprite->removeLayer(sprite->getActiveLayer());
+    refreshLayerList();
+}
+
+void SpriteEditor::handleLayerUp()
+{
+    Sprite *sprite = currentDrawingSprite;
+    sprite->moveLayer(sprite->getActiveLayer(), sprite->getActiveLayer() + 1);
+    refreshLayerList();
+}
+
+void SpriteEditor::handleLayerDown()
+{
+    Sprite *sprite = currentDrawingSprite;
+    sprite->moveLayer(sprite->getActiveLayer(), sprite->getActiveLayer() - 1);
+    refreshLayerList();
+}
+
+void SpriteEditor::layerSelected(int row)
+{
+    if (row < 0)
+        return;
+    Sprite *sprite = currentDrawingSprite;
+    sprite->setActiveLayer(sprite->getLayerCount() - 1 - row);
+
+    // Only the settings shown change, the list itself stays as it is
+    const QSignalBlocker opacityBlocker(ui->layerOpacity);
+    const QSignalBlocker blendBlocker(ui->layerBlendMode);
+    const Layer &active = sprite->getLayers()[sprite->getActiveLayer()];
+    ui->layerOpacity->setValue(active.opacity);
+    ui->layerOpacityLabel->setText(QString("Opacity: %1").arg(active.opacity));
+    ui->layerBlendMode->setCurrentIndex(int(active.blendMode));
+}
+
+void SpriteEditor::layerItemChanged(QListWidgetItem *item)
+{
+    Sprite *sprite = currentDrawingSprite;
+    int index = sprite->getLayerCount() - 1 - ui->layerList->row(item);
+    sprite->setLayerVisible(index, item->checkState() == Qt::Checked);
+}
+
+void SpriteEditor::layerOpacityChanged(int opacity)
+{
+    currentDrawingSprite->setLayerOpacity(currentDrawingSprite->getActiveLayer(), opacity);
+    ui->layerOpacityLabel->setText(QString("Opacity: %1").arg(opacity));
+}
+
+void SpriteEditor::layerBlendModeChanged(int mode)
+{
+    currentDrawingSprite->setLayerBlendMode(currentDrawingSprite->getActiveLayer(), BlendMode(mode));
+}
+
+void SpriteEditor::selectToolSelected()
+{
+    pencil->setToSelect(false);
+    ui->eraserTool->setChecked(false);
+    ui->penTool->setChecked(false);
+    ui->bucketTool->setChecked(false);
+    ui->selectTool->setChecked(true);
+    ui->lassoTool->setChecked(false);
+}
+
+void SpriteEditor::lassoToolSelected()
+{
+    pencil->setToSelect(true);
+    ui->eraserTool->setChecked(false);
+    ui->penTool->setChecked(false);
+    ui->bucketTool->setChecked(false);
+    ui->selectTool->setChecked(false);
+    ui->lassoTool->setChecked(true);
+}
+
+void SpriteEditor::handleFlipHorizontal()
+{
+    currentDrawingSprite->flipSelection(Qt::Horizontal);
+}
+
+void SpriteEditor::handleFlipVertical()
+{
+    currentDrawingSprite->flipSelection(Qt::Vertical);
+}
+
+void SpriteEditor::handleRotateClockwise()
+{
+    currentDrawingSprite->rotateSelection(true);
+}
+
+void SpriteEditor::handleRotateCounterClockwise()
+{
+    currentDrawingSprite->rotateSelection(false);
+}
+
+void SpriteEditor::handleScaleUp()
+{
+    currentDrawingSprite->scaleSelection(2.0);
+}
+
+void SpriteEditor::handleScaleDown()
+{
+    currentDrawingSprite->scaleSelection(0.5);
+}
+
+void SpriteEditor::handleDeselect()
+{
+    currentDrawingSprite->clearSelection();
 }
 
 void SpriteEditor::penSizeChanged()
@@ -415,6 +884,9 @@ void SpriteEditor::eraserSelected()
     pencil->setToEraser();
     ui->eraserTool->setChecked(true);
     ui->penTool->setChecked(false);
+    ui->bucketTool->setChecked(false);
+    ui->selectTool->setChecked(false);
+    ui->lassoTool->setChecked(false);
 }
 
 void SpriteEditor::penSelected()
@@ -422,6 +894,40 @@ void SpriteEditor::penSelected()
     pencil->setToPen();
     ui->eraserTool->setChecked(false);
     ui->penTool->setChecked(true);
+    ui->bucketTool->setChecked(false);
+    ui->selectTool->setChecked(false);
+    ui->lassoTool->setChecked(false);
+}
+
+void SpriteEditor::bucketSelected()
+{
+    pencil->setToBucket();
+    ui->eraserTool->setChecked(false);
+    ui->penTool->setChecked(false);
+    ui->bucketTool->setChecked(true);
+    ui->selectTool->setChecked(false);
+    ui->lassoTool->setChecked(false);
+}
+
+void SpriteEditor::brushShapeChanged(int shape)
+{
+    if (BrushShape(shape) == BrushShape::Custom)
+    {
+        if (!currentDrawingSprite->hasSelection())
+        {
+            ui->statusbar->showMessage(tr("Select the pixels to use as the brush first"), 3000);
+            const QSignalBlocker blocker(ui->brushShape);
+            ui->brushShape->setCurrentIndex(int(pencil->getBrushShape()));
+            return;
+        }
+        pencil->setCustomStamp(currentDrawingSprite->getImage().copy(currentDrawingSprite->getSelection()));
+    }
+    pencil->setBrushShape(BrushShape(shape));
+}
+
+void SpriteEditor::mirrorModeChanged(int mode)
+{
+    pencil->setMirrorMode(MirrorMode(mode));
 }
 
 void SpriteEditor::updatePenSizeLabel(int size)
@@ -10,6 +10,7 @@
 #ifndef SPRITEEDITOR_H
 #define SPRITEEDITOR_H
 
+#include <QCloseEvent>
 #include <QColor>
 #include <QFileDialog>
 #include <QLabel>
@@ -25,6 +26,12 @@
 #include "startmenu.h"
 #include "ui_spriteeditor.h"
 #include "playbackwindow.h"
+#include "thumbnailcache.h"
+#include "framecache.h"
+#include "framescheduler.h"
+#include "onionskin.h"
+#include "diagnostics.h"
+#include "autosave.h"
 
 
 QT_BEGIN_NAMESPACE
@@ -63,6 +70,12 @@ private slots:
      */
     void saveProject();
 
+    /**
+     * @brief exportAnimation Exports the frames of this project as a sprite sheet,
+     * animated GIF or animated PNG at the current preview speed.
+     */
+    void exportAnimation();
+
     /**
      * @brief updateColorSelector Updates the color selector slider values.
      * @param color The color to represent in the color selector sliders.
@@ -108,15 +121,35 @@ private slots:
      */
     void eraserSelected();
 
+    /**
+     * @brief bucketSelected Sets the user's cursor to bucket fill mode.
+     * Clicking fills the region under the cursor.
+     */
+    void bucketSelected();
+
+    /**
+     * @brief brushShapeChanged Changes the shape of the pen and eraser. Choosing the selection
+     * brush takes the shape of the selected pixels of the current frame.
+     * @param shape - the index of the shape, in the order of BrushShape.
+     */
+    void brushShapeChanged(int shape);
+
+    /**
+     * @brief mirrorModeChanged Changes which mirrored copies of each stroke are drawn.
+     * @param mode - the index of the mode, in the order of MirrorMode.
+     */
+    void mirrorModeChanged(int mode);
+
     /**
      * @brief Start or stop sprite animation preview
      */
     void toggleAnimation();
 
     /**
-     * @brief Let the animation box show the next frame
+     * @brief Let the animation box show the frame chosen by the scheduler
+     * @param frameIndex - the frame to show.
      */
-    void nextAnimationFrame();
+    void showAnimationFrame(int frameIndex);
 
     /**
      * @brief eyedropperToggled Sets the user's cursor to the
@@ -170,6 +203,145 @@ private slots:
      */
     void handleRedo();
 
+    /**
+     * @brief handleAddLayer Handler for when the add layer button is clicked.
+     * Adds an empty layer above the active layer of the current frame.
+     */
+    void handleAddLayer();
+
+    /**
+     * @brief handleDeleteLayer Handler for when the delete layer button is clicked.
+     * Deletes the active layer of the current frame.
+     */
+    void handleDeleteLayer();
+
+    /**
+     * @brief handleLayerUp Handler for when the move up button is clicked.
+     * Moves the active layer one step towards the top.
+     */
+    void handleLayerUp();
+
+    /**
+     * @brief handleLayerDown Handler for when the move down button is clicked.
+     * Moves the active layer one step towards the bottom.
+     */
+    void handleLayerDown();
+
+    /**
+     * @brief layerSelected Makes the chosen layer the one tools draw on.
+     * @param row - the row of the layer list, the top layer being row 0.
+     */
+    void layerSelected(int row);
+
+    /**
+     * @brief layerItemChanged Shows or hides a layer when its box is checked or unchecked.
+     * @param item - the layer list entry that changed.
+     */
+    void layerItemChanged(QListWidgetItem *item);
+
+    /**
+     * @brief layerOpacityChanged Sets the opacity of the active layer.
+     * @param opacity - 0 for invisible to 255 for fully opaque.
+     */
+    void layerOpacityChanged(int opacity);
+
+    /**
+     * @brief layerBlendModeChanged Sets the blend mode of the active layer.
+     * @param mode - the index of the mode in the blend mode box.
+     */
+    void layerBlendModeChanged(int mode);
+
+    /**
+     * @brief selectToolSelected Sets the user's cursor to rectangle selection mode.
+     */
+    void selectToolSelected();
+
+    /**
+     * @brief lassoToolSelected Sets the user's cursor to freehand selection mode.
+     */
+    void lassoToolSelected();
+
+    /**
+     * @brief handleFlipHorizontal Mirrors the selection of the current frame left to right.
+     */
+    void handleFlipHorizontal();
+
+    /**
+     * @brief handleFlipVertical Mirrors the selection of the current frame top to bottom.
+     */
+    void handleFlipVertical();
+
+    /**
+     * @brief handleRotateClockwise Turns the selection of the current frame a quarter turn clockwise.
+     */
+    void handleRotateClockwise();
+
+    /**
+     * @brief handleRotateCounterClockwise Turns the selection of the current frame a quarter turn counterclockwise.
+     */
+    void handleRotateCounterClockwise();
+
+    /**
+     * @brief handleScaleUp Doubles the size of the selection of the current frame.
+     */
+    void handleScaleUp();
+
+    /**
+     * @brief handleScaleDown Halves the size of the selection of the current frame.
+     */
+    void handleScaleDown();
+
+    /**
+     * @brief handleDeselect Clears the selection of the current frame.
+     */
+    void handleDeselect();
+
+    /**
+     * @brief onionSkinDepthChanged Changes how many neighbouring frames are shown beneath the current frame.
+     * @param frames - the number of frames on each side, 0 to turn onion skinning off.
+     */
+    void onionSkinDepthChanged(int frames);
+
+    /**
+     * @brief indexedModeToggled Turns storing frames as palette indices on or off.
+     * @param indexed - whether frames are stored as palette indices.
+     */
+    void indexedModeToggled(bool indexed);
+
+    /**
+     * @brief paletteColorPicked Makes a palette color the current drawing color.
+     * @param item - the palette entry that was double clicked.
+     */
+    void paletteColorPicked(QListWidgetItem *item);
+
+    /**
+     * @brief handleReplacePaletteColor Changes the selected palette color to the current drawing
+     * color, recoloring every frame that uses it.
+     */
+    void handleReplacePaletteColor();
+
+    /**
+     * @brief refreshPaletteList Shows the colors of the project palette.
+     */
+    void refreshPaletteList();
+
+    /**
+     * @brief diagnosticsToggled Starts or stops recording timings and shows or hides the overlay.
+     * @param enabled Whether diagnostics are recorded.
+     */
+    void diagnosticsToggled(bool enabled);
+
+    /**
+     * @brief handleExportTrace Saves the recorded timings as Chrome trace JSON.
+     */
+    void handleExportTrace();
+
+    /**
+     * @brief refreshDiagnostics Shows the latest timings and memory use in the overlay and records
+     * the memory counters for the trace.
+     */
+    void refreshDiagnostics();
+
 public slots:
 
     /**
@@ -185,9 +357,17 @@ public slots:
 
     /**
      * @brief Function to update the appearance of the frame icons in the frame menu.
+     * Only frames that changed are rescaled, shortly afterwards and off the GUI thread.
      */
     void updateFrameIcons();
 
+    /**
+     * @brief Function to show a regenerated icon in the frame menu.
+     * @param frameIndex - the position of the frame in the menu.
+     * @param icon - the scaled image of the frame.
+     */
+    void setFrameIcon(int frameIndex, const QImage &icon);
+
     /**
      * @brief Function to switch a frame in the preview with the provided frame.
      * @param frame - the frame to switch the current with.
@@ -201,14 +381,27 @@ public slots:
      */
     void frameFocus(Sprite *sprite);
 
-private:
     /**
-     * @brief Show the given image in given widget using Pixmap and QLabel.
-     * @param img - Image to been shown.
-     * @param box - Widget to show the image.
+     * @brief Function to show the layers of the current frame in the layer list,
+     * along with the settings of the active layer.
      */
-    void showImg(QImage img, QWidget *box);
+    void refreshLayerList();
 
+    /**
+     * @brief Function to show the neighbours of the current frame beneath it. They are only
+     * blended again if one of them changed since the last call.
+     */
+    void refreshOnionSkin();
+
+protected:
+
+    /**
+     * @brief closeEvent Stops autosaving, playback and diagnostics when the editor is closed.
+     * @param event - the close event.
+     */
+    void closeEvent(QCloseEvent *event) override;
+
+private:
     /**
      * @brief the view instance of the editor.
      */
@@ -230,19 +423,49 @@ private:
     Pencil *pencil;
 
     /**
-     * @brief a timer used to control the speed of the playback animation.
+     * @brief the cache that regenerates frame menu icons when frames change.
      */
-    QTimer *animationTimer;
+    ThumbnailCache *thumbnails;
 
     /**
-     * @brief The position of the current frame in the editor and preview menu.
+     * @brief the label inside the preview box that shows the current animation frame.
      */
-    int currentFrameIndex = 0;
+    QLabel *animationLabel;
+
+    /**
+     * @brief the animation frames, scaled to the preview box and converted once per edit.
+     */
+    FrameCache previewCache;
+
+    /**
+     * @brief the scheduler that paces the preview animation.
+     */
+    FrameScheduler *animationScheduler;
+
+    /**
+     * @brief the neighbouring frames blended into the underlay of the current frame.
+     */
+    OnionSkin onionSkin;
 
     /**
-     * @brief The position of the current frame in the playback sequence.
+     * @brief the background autosave of the project.
      */
-    int currentAnimationFrameIndex = 0;
+    Autosave *autosave;
+
+    /**
+     * @brief the label drawn over the canvas showing the diagnostics.
+     */
+    QLabel *diagnosticsOverlay;
+
+    /**
+     * @brief the timer that refreshes the diagnostics overlay while it is shown.
+     */
+    QTimer diagnosticsTimer;
+
+    /**
+     * @brief The position of the current frame in the editor and preview menu.
+     */
+    int currentFrameIndex = 0;
 };
 
 #endif // SPRITEEDITOR_H
@@ -0,0 +1,589 @@
+/**
+ * Implementation of the SpriteExporter class, which exports animations for use outside the editor.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer John Gibb
+ */
+
+#include "spriteexporter.h"
+#include "pixelops.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFileInfo>
+#include <QFuture>
+#include <QHash>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <QtMath>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+// GIF palettes hold at most this many entries, one of which is kept for transparency.
+const int MaxGifColors = 256;
+
+// Pixels less opaque than this become the transparent palette entry of a GIF.
+const int GifAlphaThreshold = 128;
+
+// LZW codes in a GIF are at most 12 bits wide.
+const int MaxLzwCode = 4095;
+
+// A distinct color of a frame and how many pixels use it.
+struct ColorCount
+{
+    QRgb color;
+    int count;
+};
+
+// Gets the red, green or blue component of a color.
+int channelValue(QRgb color, int channel)
+{
+    return channel == 0 ? qRed(color) : channel == 1 ? qGreen(color) : qBlue(color);
+}
+
+// The CRC used by PNG chunks.
+quint32 crc32(const QByteArray &bytes)
+{
+    static const QVector<quint32> table = [] {
+        QVector<quint32> values(256);
+        for (quint32 n = 0; n < 256; ++n)
+        {
+            quint32 c = n;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            values[n] = c;
+        }
+        return values;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (char byte : bytes)
+    {
+        crc = table[(crc ^ uchar(byte)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+}
+
+bool SpriteExporter::formatForFile(const QString &fileName, Format &format)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "png")
+    {
+        format = Format::SpriteSheet;
+    }
+    else if (suffix == "gif")
+    {
+        format = Format::Gif;
+    }
+    else if (suffix == "apng")
+    {
+        format = Format::Apng;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool SpriteExporter::exportFile(const QVector<QImage> &frames, const QString &fileName, int fps)
+{
+    Format format;
+    if (!formatForFile(fileName, format))
+    {
+        qWarning() << "Unknown export format for" << fileName;
+        return false;
+    }
+
+    if (frames.isEmpty())
+    {
+        return false;
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Could not open" << fileName << "for export";
+        return false;
+    }
+
+    bool ok = false;
+    switch (format)
+    {
+    case Format::SpriteSheet:
+        ok = packSpriteSheet(frames).save(&file, "PNG");
+        break;
+    case Format::Gif:
+        ok = writeGif(frames, file, fps);
+        break;
+    case Format::Apng:
+        ok = writeApng(frames, file, fps);
+        break;
+    }
+
+    if (!ok)
+    {
+        file.cancelWriting();
+    }
+    return file.commit() && ok;
+}
+
+QImage SpriteExporter::packSpriteSheet(const QVector<QImage> &frames, int columns)
+{
+    if (frames.isEmpty())
+    {
+        return QImage();
+    }
+
+    if (columns <= 0)
+    {
+        columns = qCeil(qSqrt(frames.size()));
+    }
+    const int rows = (int(frames.size()) + columns - 1) / columns;
+
+    QSize cell;
+    for (const QImage &frame : frames)
+    {
+        cell = cell.expandedTo(frame.size());
+    }
+
+    QImage sheet(cell.width() * columns, cell.height() * rows, QImage::Format_ARGB32);
+    sheet.fill(Qt::transparent);
+    for (int i = 0; i < frames.size(); ++i)
+    {
+        const QPoint cellOrigin((i % columns) * cell.width(), (i / columns) * cell.height());
+        PixelOps::blit(sheet, frames[i].convertToFormat(QImage::Format_ARGB32), cellOrigin);
+    }
+    return sheet;
+}
+
+bool SpriteExporter::writeGif(const QVector<QImage> &frames, QIODevice &device, int fps)
+{
+    if (frames.isEmpty())
+    {
+        return false;
+    }
+
+    // GIF delays are in hundredths of a second and most viewers ignore anything under two
+    const int delay = qMax(2, qRound(100.0 / qMax(1, fps)));
+
+    // Every frame is quantized and compressed on the pool while earlier ones are written out
+    QFuture<QByteArray> encoded = QtConcurrent::mapped(frames, [delay](const QImage &frame) {
+        return encodeGifFrame(frame, delay);
+    });
+
+    const QSize size = frames.first().size();
+    QByteArray header;
+    {
+        QDataStream out(&header, QIODevice::WriteOnly);
+        out.setByteOrder(QDataStream::LittleEndian);
+        out.writeRawData("GIF89a", 6);
+        out << quint16(size.width())
+            << quint16(size.height())
+            << quint8(0)    // No global color table, every frame has its own
+            << quint8(0)    // Background color index
+            << quint8(0);   // Pixel aspect ratio
+
+        // Application extension asking viewers to loop forever
+        out << quint8(0x21) << quint8(0xFF) << quint8(11);
+        out.writeRawData("NETSCAPE2.0", 11);
+        out << quint8(3) << quint8(1) << quint16(0) << quint8(0);
+    }
+
+    bool ok = device.write(header) == header.size();
+    for (int i = 0; i < frames.size() && ok; ++i)
+    {
+        const QByteArray frame = encoded.resultAt(i);  // Waits for this frame only
+        ok = device.write(frame) == frame.size();
+    }
+
+    if (!ok)
+    {
+        encoded.cancel();
+        encoded.waitForFinished();
+        return false;
+    }
+    return device.putChar(0x3B);    // Trailer
+}
+
+bool SpriteExporter::writeApng(const QVector<QImage> &frames, QIODevice &device, int fps)
+{
+    if (frames.isEmpty())
+    {
+        return false;
+    }
+
+    QFuture<QByteArray> encoded = QtConcurrent::mapped(frames, &SpriteExporter::encodePngImageData);
+
+    const QSize size = frames.first().size();
+    QByteArray header;
+    {
+        QDataStream out(&header, QIODevice::WriteOnly);
+        out << quint32(size.width())
+            << quint32(size.height())
+            << quint8(8)    // Bits per channel
+            << quint8(6)    // Truecolor with alpha
+            << quint8(0)    // Deflate
+            << quint8(0)    // Adaptive filtering
+            << quint8(0);   // Not interlaced
+    }
+
+    QByteArray animationControl;
+    {
+        QDataStream out(&animationControl, QIODevice::WriteOnly);
+        out << quint32(frames.size())
+            << quint32(0);  // Loop forever
+    }
+
+    bool ok = device.write("\x89PNG\r\n\x1a\n", 8) == 8
+              && writePngChunk(device, "IHDR", header)
+              && writePngChunk(device, "acTL", animationControl);
+
+    // Frame control and frame data chunks share one sequence
+    quint32 sequence = 0;
+    for (int i = 0; i < frames.size() && ok; ++i)
+    {
+        QByteArray frameControl;
+        {
+            QDataStream out(&frameControl, QIODevice::WriteOnly);
+            out << sequence++
+                << quint32(size.width())
+                << quint32(size.height())
+                << quint32(0)       // X offset
+                << quint32(0)       // Y offset
+                << quint16(1)       // Delay of 1 / fps seconds
+                << quint16(qMax(1, fps))
+                << quint8(0)        // Leave the frame in place
+                << quint8(0);       // Replace the previous frame rather than blending over it
+        }
+        ok = writePngChunk(device, "fcTL", frameControl);
+
+        const QByteArray data = encoded.resultAt(i);
+        if (i == 0)
+        {
+            // The first frame doubles as the still image for viewers without APNG support
+            ok = ok && writePngChunk(device, "IDAT", data);
+        }
+        else
+        {
+            QByteArray frameData;
+            QDataStream(&frameData, QIODevice::WriteOnly) << sequence++;
+            frameData.append(data);
+            ok = ok && writePngChunk(device, "fdAT", frameData);
+        }
+    }
+
+    if (!ok)
+    {
+        encoded.cancel();
+        encoded.waitForFinished();
+        return false;
+    }
+    return writePngChunk(device, "IEND", QByteArray());
+}
+
+SpriteExporter::IndexedFrame SpriteExporter::quantize(const QImage &frame)
+{
+    const QImage argb = frame.convertToFormat(QImage::Format_ARGB32);
+
+    // Visible pixels are counted as opaque colors, the rest all map to index 0
+    QHash<QRgb, int> histogram;
+    for (int y = 0; y < argb.height(); ++y)
+    {
+        const QRgb *row = PixelOps::constRow(argb, y);
+        for (int x = 0; x < argb.width(); ++x)
+        {
+            if (qAlpha(row[x]) >= GifAlphaThreshold)
+            {
+                histogram[row[x] | 0xFF000000]++;
+            }
+        }
+    }
+
+    IndexedFrame indexed;
+    indexed.palette.append(qRgba(0, 0, 0, 0));
+    QHash<QRgb, uchar> lookup;
+
+    if (histogram.size() < MaxGifColors)
+    {
+        // Small enough to keep every color exactly
+        for (auto it = histogram.constBegin(); it != histogram.constEnd(); ++it)
+        {
+            lookup.insert(it.key(), uchar(indexed.palette.size()));
+            indexed.palette.append(it.key());
+        }
+    }
+    else
+    {
+        // Median cut: keep splitting the box with the widest channel at its weighted median
+        std::vector<ColorCount> colors;
+        colors.reserve(histogram.size());
+        for (auto it = histogram.constBegin(); it != histogram.constEnd(); ++it)
+        {
+            colors.push_back({it.key(), it.value()});
+        }
+
+        QVector<QPair<int, int>> boxes{{0, int(colors.size())}};
+        while (boxes.size() < MaxGifColors - 1)
+        {
+            int best = -1;
+            int bestRange = 0;
+            int bestChannel = 0;
+            for (int b = 0; b < boxes.size(); ++b)
+            {
+                int low[3] = {255, 255, 255};
+                int high[3] = {0, 0, 0};
+                for (int i = boxes[b].first; i < boxes[b].second; ++i)
+                {
+                    for (int channel = 0; channel < 3; ++channel)
+                    {
+                        int value = channelValue(colors[i].color, channel);
+                        low[channel] = qMin(low[channel], value);
+                        high[channel] = qMax(high[channel], value);
+                    }
+                }
+                for (int channel = 0; channel < 3; ++channel)
+                {
+                    if (high[channel] - low[channel] > bestRange)
+                    {
+                        best = b;
+                        bestRange = high[channel] - low[channel];
+                        bestChannel = channel;
+                    }
+                }
+            }
+
+            if (best < 0)
+            {
+                break;  // Every box holds a single color
+            }
+
+            const int begin = boxes[best].first;
+            const int end = boxes[best].second;
+            std::sort(colors.begin() + begin, colors.begin() + end,
+                      [bestChannel](const ColorCount &a, const ColorCount &b) {
+                          return channelValue(a.color, bestChannel) < channelValue(b.color, bestChannel);
+                      });
+
+            qint64 total = 0;
+            for (int i = begin; i < end; ++i)
+            {
+                total += colors[i].count;
+            }
+
+            // Both halves keep at least one color
+            int split = begin + 1;
+            qint64 below = colors[begin].count;
+            while (split < end - 1 && below + colors[split].count <= total / 2)
+            {
+                below += colors[split].count;
+                ++split;
+            }
+
+            boxes[best] = {begin, split};
+            boxes.append({split, end});
+        }
+
+        for (const QPair<int, int> &box : boxes)
+        {
+            qint64 red = 0;
+            qint64 green = 0;
+            qint64 blue = 0;
+            qint64 total = 0;
+            for (int i = box.first; i < box.second; ++i)
+            {
+                red += qint64(qRed(colors[i].color)) * colors[i].count;
+                green += qint64(qGreen(colors[i].color)) * colors[i].count;
+                blue += qint64(qBlue(colors[i].color)) * colors[i].count;
+                total += colors[i].count;
+                lookup.insert(colors[i].color, uchar(indexed.palette.size()));
+            }
+            indexed.palette.append(qRgb(int((red + total / 2) / total),
+                                        int((green + total / 2) / total),
+                                        int((blue + total / 2) / total)));
+        }
+    }
+
+    indexed.indices.resize(qsizetype(argb.width()) * argb.height());
+    uchar *out = reinterpret_cast<uchar *>(indexed.indices.data());
+    for (int y = 0; y < argb.height(); ++y)
+    {
+        const QRgb *row = PixelOps::constRow(argb, y);
+        for (int x = 0; x < argb.width(); ++x)
+        {
+            *out++ = qAlpha(row[x]) >= GifAlphaThreshold ? lookup.value(row[x] | 0xFF000000) : 0;
+        }
+    }
+    return indexed;
+}
+
+QByteArray SpriteExporter::encodeGifFrame(const QImage &frame, int delay)
+{
+    const IndexedFrame indexed = quantize(frame);
+
+    // Color tables hold a power of two entries
+    int bits = 1;
+    while ((1 << bits) < indexed.palette.size())
+    {
+        ++bits;
+    }
+
+    QByteArray block;
+    QDataStream out(&block, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    // Graphic control extension: clear to transparent before the next frame, index 0 is transparent
+    out << quint8(0x21) << quint8(0xF9) << quint8(4)
+        << quint8(0x09)
+        << quint16(delay)
+        << quint8(0)
+        << quint8(0);
+
+    // Image descriptor covering the whole canvas, followed by the local color table
+    out << quint8(0x2C)
+        << quint16(0)
+        << quint16(0)
+        << quint16(frame.width())
+        << quint16(frame.height())
+        << quint8(0x80 | (bits - 1));
+    for (int i = 0; i < (1 << bits); ++i)
+    {
+        QRgb color = i < indexed.palette.size() ? indexed.palette[i] : 0;
+        out << quint8(qRed(color)) << quint8(qGreen(color)) << quint8(qBlue(color));
+    }
+
+    // LZW data, split into sub-blocks of at most 255 bytes
+    const int minCodeSize = qMax(2, bits);
+    const QByteArray data = lzwEncode(indexed.indices, minCodeSize);
+    out << quint8(minCodeSize);
+    for (qsizetype pos = 0; pos < data.size(); pos += 255)
+    {
+        int length = int(qMin<qsizetype>(255, data.size() - pos));
+        out << quint8(length);
+        out.writeRawData(data.constData() + pos, length);
+    }
+    out << quint8(0);
+
+    return block;
+}
+
+QByteArray SpriteExporter::lzwEncode(const QByteArray &indices, int minCodeSize)
+{
+    const int clearCode = 1 << minCodeSize;
+    const int endCode = clearCode + 1;
+
+    // The dictionary as a trie: the code of each string extended by each possible index, 0 if absent
+    std::vector<quint16> children(size_t(MaxLzwCode + 1) * 256, 0);
+
+    QByteArray out;
+    out.reserve(indices.size() / 2);
+    quint32 buffer = 0;
+    int bufferedBits = 0;
+    auto writeCode = [&](int code, int size) {
+        buffer |= quint32(code) << bufferedBits;
+        bufferedBits += size;
+        while (bufferedBits >= 8)
+        {
+            out.append(char(buffer & 0xFF));
+            buffer >>= 8;
+            bufferedBits -= 8;
+        }
+    };
+
+    int codeSize = minCodeSize + 1;
+    int lastCode = endCode;
+    writeCode(clearCode, codeSize);
+
+    int current = -1;
+    for (char byte : indices)
+    {
+        const int next = uchar(byte);
+        if (current < 0)
+        {
+            current = next;
+            continue;
+        }
+
+        quint16 &child = children[size_t(current) * 256 + next];
+        if (child)
+        {
+            current = child;
+            continue;
+        }
+
+        writeCode(current, codeSize);
+        child = quint16(++lastCode);
+        if (lastCode >= (1 << codeSize))
+        {
+            ++codeSize;
+        }
+
+        // Start over once the 12-bit code space is used up
+        if (lastCode == MaxLzwCode)
+        {
+            writeCode(clearCode, codeSize);
+            std::fill(children.begin(), children.end(), 0);
+            codeSize = minCodeSize + 1;
+            lastCode = endCode;
+        }
+        current = next;
+    }
+
+    if (current >= 0)
+    {
+        writeCode(current, codeSize);
+
+        // The decoder adds an entry for this last code too, and may widen its codes for the ones after it
+        if (lastCode + 1 >= (1 << codeSize) && codeSize < 12)
+        {
+            ++codeSize;
+        }
+    }
+    writeCode(clearCode, codeSize);
+    writeCode(endCode, minCodeSize + 1);
+    if (bufferedBits > 0)
+    {
+        out.append(char(buffer & 0xFF));
+    }
+    return out;
+}
+
+QByteArray SpriteExporter::encodePngImageData(const QImage &frame)
+{
+    // RGBA8888 is stored in byte order on every platform, exactly as PNG wants it
+    const QImage rgba = frame.convertToFormat(QImage::Format_RGBA8888);
+    const qsizetype rowBytes = qsizetype(rgba.width()) * 4;
+
+    // Each row is stored with the Sub filter, which shrinks runs of equal pixels to zeros
+    QByteArray raw((rowBytes + 1) * rgba.height(), Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar *>(raw.data());
+    for (int y = 0; y < rgba.height(); ++y)
+    {
+        const uchar *row = rgba.constScanLine(y);
+        *out++ = 1;
+        for (qsizetype i = 0; i < rowBytes; ++i)
+        {
+            *out++ = uchar(row[i] - (i >= 4 ? row[i - 4] : 0));
+        }
+    }
+
+    // qCompress prefixes the zlib stream with its own 4 byte length, which PNG does not expect
+    return qCompress(raw).mid(4);
+}
+
+bool SpriteExporter::writePngChunk(QIODevice &device, const QByteArray &type, const QByteArray &data)
+{
+    QByteArray chunk;
+    QDataStream out(&chunk, QIODevice::WriteOnly);
+    out << quint32(data.size());
+    out.writeRawData(type.constData(), 4);
+    out.writeRawData(data.constData(), int(data.size()));
+    out << crc32(chunk.mid(4));
+    return device.write(chunk) == chunk.size();
+}
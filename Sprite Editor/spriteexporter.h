@@ -0,0 +1,110 @@
+/**
+ * Declaration of the SpriteExporter class, which exports animations for use outside the editor.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer John Gibb
+ */
+
+#ifndef SPRITEEXPORTER_H
+#define SPRITEEXPORTER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QImage>
+#include <QRgb>
+#include <QString>
+#include <QVector>
+
+/**
+ * The SpriteExporter class turns a sequence of frames into a sprite sheet, an animated GIF
+ * or an animated PNG. It works on plain QImages and never touches widgets, so it can run
+ * without a GUI. Frame encoding, including the palette quantization needed for GIF, runs in
+ * parallel on the global thread pool, and encoded frames are written to the output in order
+ * as soon as they are ready.
+ */
+class SpriteExporter
+{
+public:
+
+    /**
+     * The file formats frames can be exported to.
+     */
+    enum class Format
+    {
+        SpriteSheet,
+        Gif,
+        Apng
+    };
+
+    /**
+     * @brief Picks the export format from a file name: .png for a sprite sheet, .gif for an
+     * animated GIF and .apng for an animated PNG.
+     * @param fileName The path being exported to.
+     * @param format Set to the matching format.
+     * @return True if the extension names a supported format.
+     */
+    static bool formatForFile(const QString &fileName, Format &format);
+
+    /**
+     * @brief Exports frames to a file in the format named by its extension.
+     * @param frames The frames of the animation, all of the same size.
+     * @param fileName The path to export to.
+     * @param fps The playback speed of animated formats.
+     * @return True if the file was written.
+     */
+    static bool exportFile(const QVector<QImage> &frames, const QString &fileName, int fps);
+
+    /**
+     * @brief Packs frames left to right, top to bottom into a grid.
+     * @param frames The frames to pack.
+     * @param columns The number of frames per row, or 0 for a roughly square sheet.
+     * @return The sprite sheet, or a null image if there are no frames.
+     */
+    static QImage packSpriteSheet(const QVector<QImage> &frames, int columns = 0);
+
+    /**
+     * @brief Writes frames as a looping animated GIF. Each frame gets its own palette of up to
+     * 255 colors, reduced with median cut when needed, plus one fully transparent entry.
+     * @param frames The frames of the animation, all of the same size.
+     * @param device The open device to write to.
+     * @param fps The playback speed of the animation.
+     * @return True if every byte was written.
+     */
+    static bool writeGif(const QVector<QImage> &frames, QIODevice &device, int fps);
+
+    /**
+     * @brief Writes frames as a looping animated PNG in full 32-bit color.
+     * @param frames The frames of the animation, all of the same size.
+     * @param device The open device to write to.
+     * @param fps The playback speed of the animation.
+     * @return True if every byte was written.
+     */
+    static bool writeApng(const QVector<QImage> &frames, QIODevice &device, int fps);
+
+private:
+
+    // A frame reduced to palette indices. Index 0 is always fully transparent.
+    struct IndexedFrame
+    {
+        QVector<QRgb> palette;
+        QByteArray indices;
+    };
+
+    // Reduces a frame to at most 256 palette entries.
+    static IndexedFrame quantize(const QImage &frame);
+
+    // Encodes one frame as a complete GIF image block, including its control extension.
+    static QByteArray encodeGifFrame(const QImage &frame, int delay);
+
+    // Compresses palette indices with the variable-length LZW coding used by GIF.
+    static QByteArray lzwEncode(const QByteArray &indices, int minCodeSize);
+
+    // Filters and deflates the rows of a frame into PNG image data.
+    static QByteArray encodePngImageData(const QImage &frame);
+
+    // Writes a PNG chunk with its length and checksum.
+    static bool writePngChunk(QIODevice &device, const QByteArray &type, const QByteArray &data);
+};
+
+#endif // SPRITEEXPORTER_H
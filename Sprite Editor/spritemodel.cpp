@@ -1,5 +1,5 @@
 /**
- * Handles spritie project state. Manages frames, clipboard actions, and undo/redo history. Handles save / load from JSON.
+ * Handles spritie project state. Manages frames, clipboard actions, and undo/redo history. Handles save / load of .ssp files.
  *
  * @author John Gibb
  * @date March 31, 2025
@@ -7,6 +7,16 @@
  */
 
 #include "spritemodel.h"
+#include "spriteexporter.h"
+
+#include <QDebug>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QSet>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
 
 SpriteModel::SpriteModel(int defaultSize, QObject *parent)
     : QObject(parent)
@@ -18,55 +28,51 @@ SpriteModel::SpriteModel(int defaultSize, QObject *parent)
 
 void SpriteModel::loadProject(const QString &fileName)
 {
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly))
+    ProjectFile project(fileName);
+    if (!project.openForRead())
         return;
 
-    QByteArray data = file.readAll();
-    file.close();
-
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    QJsonObject root = doc.object();
+    this->fileName = fileName;
 
     frames.clear();
+    editingFrame = nullptr;
+    lastFocused.clear();
 
-    if (!root.contains("frames") || !root["frames"].isArray())
-    {
-        qWarning() << "Invalid file format: missing frames array";
-        return;
-    }
-
-    QJsonArray framesArray = root["frames"].toArray();
-    for (int i = 0; i < framesArray.size(); ++i)
+    QVector<QRgb> projectPalette;
+    if (project.isLegacyJson())
     {
-        QJsonObject spriteObj = framesArray[i].toObject();
-        if (!spriteObj.contains("spriteSize") || !spriteObj.contains("pixels"))
+        // legacy JSON is parsed as a whole, so its frames are converted in order
+        QImage img;
+        while (project.readFrame(img))
         {
-            qWarning() << "Frame" << i << "missing required fields";
-            continue;
+            Layer layer;
+            layer.name = "Layer 1";
+            layer.image = img;
+            Sprite *sprite = new Sprite(img.width());
+            sprite->setLayers({layer});
+            frames.append(sprite);
+            emit loadProgress(frames.size(), project.getFrameCount());
         }
-
-        int size = spriteObj["spriteSize"].toInt();
-        Sprite *sprite = new Sprite(size);
-        QImage img(size, size, QImage::Format_ARGB32);
-
-        QJsonArray rows = spriteObj["pixels"].toArray();
-        for (int y = 0; y < size && y < rows.size(); ++y)
+        project.close();
+        shareFrames();
+    }
+    else
+    {
+        // only the record index is read here, each frame is decoded the first time it is needed, and frames
+        // saved as duplicates are read from the frame they repeat so they are found identical without decoding
+        project.close();
+        QSharedPointer<FrameStore> store(new FrameStore(fileName));
+        if (store->open())
         {
-            QJsonArray row = rows[y].toArray();
-            for (int x = 0; x < size && x < row.size(); ++x)
+            for (int i = 0; i < store->getFrameCount(); ++i)
             {
-                QJsonObject pix = row[x].toObject();
-                int r = pix["r"].toInt();
-                int g = pix["g"].toInt();
-                int b = pix["b"].toInt();
-                int a = pix["a"].toInt();
-                img.setPixelColor(x, y, QColor(r, g, b, a));
+                Sprite *sprite = new Sprite();
+                sprite->setUnloaded({QByteArray(), store, store->getSourceFrame(i)}, store->getSpriteSize());
+                frames.append(sprite);
             }
+            projectPalette = store->getPalette();
+            emit loadProgress(frames.size(), frames.size());
         }
-
-        sprite->setImage(img);
-        frames.append(sprite);
     }
 
     if (frames.isEmpty())
@@ -76,51 +82,133 @@ void SpriteModel::loadProject(const QString &fileName)
         frames.append(new Sprite(2));
         frameIndex = 0;
     }
+
+    // projects saved with a palette reopen in indexed mode with the same color order
+    palette.setColors(projectPalette);
+    indexedMode = !projectPalette.isEmpty();
+    if (indexedMode)
+    {
+        compactFrames();
+    }
+    emit paletteChanged();
 }
 
 void SpriteModel::saveProject(const QString &fileName)
 {
-    QJsonObject root;
-    QJsonArray framesArray;
+    ProjectFile project(fileName);
+    if (!project.openForWrite(frames.first()->getSpriteSize(), frames.size(),
+                              indexedMode ? palette.getColors() : QVector<QRgb>()))
+    {
+        qWarning() << "Could not open" << fileName << "for writing";
+        return;
+    }
 
-    // iterate over each sprite frame
+    // shallow copies, so frames edited during the save do not affect it, frames unchanged since they
+    // were loaded or last saved pass their stored record through without being decoded, and frames
+    // repeating an earlier frame are neither encoded nor read
+    const QVector<int> identical = findIdenticalFrames();
+    QList<QPair<QVector<Layer>, StoredFrame>> sources;
+    QVector<quint64> versions;
     for (int i = 0; i < frames.size(); ++i)
     {
-        const Sprite *sprite = frames[i];
-        QJsonObject spriteObj;
-        QJsonArray rows;
-        int size = sprite->getSpriteSize();
+        const StoredFrame stored = identical[i] == i ? frames[i]->getStoredFrame() : StoredFrame();
+        const bool encode = identical[i] == i && stored.isNull();
+        sources.append({encode ? frames[i]->getLayers() : QVector<Layer>(), stored});
+        versions.append(frames[i]->getVersion());
+    }
+
+    QFuture<QByteArray> future = QtConcurrent::mapped(sources, [](const QPair<QVector<Layer>, StoredFrame> &source) {
+        if (!source.second.isNull())
+        {
+            return source.second.read();
+        }
+        return source.first.isEmpty() ? QByteArray() : ProjectFile::encodeLayers(source.first);
+    });
+    const int total = sources.size();
+    int written = 0;
+
+    // encoded records finish out of order, write each one as soon as all before it are written
+    auto writeReady = [&]() {
+        while (written < total && future.isResultReadyAt(written))
+        {
+            if (identical[written] != written)
+            {
+                project.writeDuplicate(identical[written]);
+            }
+            else
+            {
+                project.writeRecord(future.resultAt(written));
+            }
+            written++;
+            emit saveProgress(written, total);
+        }
+    };
+
+    QFutureWatcher<QByteArray> watcher;
+    QEventLoop loop;
+    connect(&watcher, &QFutureWatcherBase::resultReadyAt, this, writeReady);
+    connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+    watcher.setFuture(future);
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+    writeReady();
+
+    // a project saved over the file its frames are read from lets go of it first, the clipboard
+    // copy is decoded as it has nowhere else to read from
+    if (clipBoardData)
+    {
+        clipBoardData->load();
+    }
+    for (const auto &source : std::as_const(sources))
+    {
+        if (source.second.store && QFileInfo(source.second.store->getFileName()) == QFileInfo(fileName))
+        {
+            source.second.store->close();
+        }
+    }
+
+    if (!project.close())
+    {
+        qWarning() << "Failed to write" << fileName;
+        return;
+    }
+    this->fileName = fileName;
 
-        // build the pixel array row by row
-        for (int y = 0; y < size; ++y)
+    // frames unchanged since the save are read back from the saved file when they are unloaded
+    QSharedPointer<FrameStore> store(new FrameStore(fileName));
+    if (store->open() && store->getFrameCount() == frames.size())
+    {
+        for (int i = 0; i < frames.size(); ++i)
         {
-            QJsonArray row;
-            for (int x = 0; x < size; ++x)
+            if (frames[i]->getVersion() == versions[i])
             {
-                QColor c = sprite->getPixel(x, y);
-                QJsonObject pixelObj{{"r", c.red()},
-                                     {"g", c.green()},
-                                     {"b", c.blue()},
-                                     {"a", c.alpha()}};
-                row.append(pixelObj);
+                frames[i]->setStoredFrame({QByteArray(), store, store->getSourceFrame(i)});
             }
-            rows.append(row);
         }
+    }
+}
 
-        spriteObj["pixels"] = rows;
-        spriteObj["spriteSize"] = size;
-        framesArray.append(spriteObj);
+bool SpriteModel::exportAnimation(const QString &fileName, int fps)
+{
+    QVector<QImage> images;
+    for (const Sprite *sprite : frames)
+    {
+        images.append(sprite->getImage());
     }
 
-    root["frames"] = framesArray;
+    // The exporter waits on encoders running in the global pool, so it gets a thread of its own
+    QThreadPool writerPool;
+    QFutureWatcher<bool> watcher;
+    QEventLoop loop;
+    connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+    watcher.setFuture(QtConcurrent::run(&writerPool, SpriteExporter::exportFile, images, fileName, fps));
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
 
-    // write the JSON document to file (use .ssp extension)
-    QFile file(fileName);
-    if (file.open(QIODevice::WriteOnly))
+    if (!watcher.result())
     {
-        file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
-        file.close();
+        qWarning() << "Failed to export" << fileName;
+        return false;
     }
+    return true;
 }
 
 void SpriteModel::copy(int frame)
@@ -151,6 +239,11 @@ void SpriteModel::deleteFrame(int framePos)
     if (framePos < frames.size() && frames.size() > 0)
     {
         Sprite *toDelete = frames[framePos];
+        if (toDelete == editingFrame)
+        {
+            editingFrame = nullptr;
+        }
+        lastFocused.remove(toDelete);
         int spriteSize = frames[0]->getSpriteSize();
         frames.removeAt(framePos);
         delete toDelete;
@@ -178,3 +271,242 @@ int SpriteModel::getFrameCount() const
 {
     return frames.size();
 }
+
+void SpriteModel::setIndexedMode(bool indexed)
+{
+    if (indexed == indexedMode)
+    {
+        return;
+    }
+
+    indexedMode = indexed;
+    if (indexedMode)
+    {
+        compactFrames();
+    }
+    else
+    {
+        // unloaded frames decode to full colors anyway when they are next needed
+        for (Sprite *sprite : std::as_const(frames))
+        {
+            if (sprite->isLoaded())
+            {
+                sprite->expand();
+            }
+        }
+    }
+
+    // frames converted one by one no longer share their pixels
+    shareFrames();
+}
+
+bool SpriteModel::isIndexedMode() const
+{
+    return indexedMode;
+}
+
+qsizetype SpriteModel::getMemoryUsage() const
+{
+    QSet<qint64> counted;
+    qsizetype bytes = 0;
+    for (const Sprite *frame : frames)
+    {
+        bytes += frame->getMemoryUsage(counted);
+    }
+    return bytes;
+}
+
+const ColorPalette &SpriteModel::getPalette() const
+{
+    return palette;
+}
+
+void SpriteModel::setPaletteColor(int index, QRgb color)
+{
+    if (index < 0 || index >= palette.getColors().size())
+    {
+        return;
+    }
+
+    // unloaded frames keep the change with their stored pixels and are recolored when they are next decoded,
+    // only one whose colors the palette holds twice is loaded, and indexed as it loads
+    QVector<QRgb> recolored = palette.getColors();
+    recolored[index] = color;
+    for (Sprite *sprite : std::as_const(frames))
+    {
+        if (!sprite->isLoaded() && !sprite->recolorUnloaded(palette.getColors(), recolored))
+        {
+            sprite->load();
+            sprite->compact(palette);
+        }
+    }
+    if (clipBoardData && !clipBoardData->isLoaded()
+        && !clipBoardData->recolorUnloaded(palette.getColors(), recolored))
+    {
+        clipBoardData->load();
+        clipBoardData->compact(palette);
+    }
+    compactFrames();
+
+    // the edited frame is indexed for the swap too, with the old colors, so its pixels follow it
+    if (editingFrame && !editingFrame->compact(palette))
+    {
+        qWarning() << "The edited frame has too many colors to be recolored";
+    }
+
+    palette.setColor(index, color);
+    for (Sprite *sprite : std::as_const(frames))
+    {
+        sprite->setColorTable(palette.getColors());
+    }
+    if (clipBoardData)
+    {
+        clipBoardData->setColorTable(palette.getColors());
+    }
+
+    if (editingFrame)
+    {
+        editingFrame->expand();
+    }
+
+    // each frame got its own color tables, so identical frames are shared again
+    shareFrames();
+    evictFrames();
+    emit paletteChanged();
+}
+
+void SpriteModel::focusFrame(Sprite *sprite)
+{
+    editingFrame = sprite;
+    lastFocused[sprite] = ++focusCount;
+    editingFrame->load();
+    if (indexedMode)
+    {
+        editingFrame->expand();
+        compactFrames();
+    }
+    shareFrames();
+    evictFrames();
+}
+
+void SpriteModel::setFrameMemoryBudget(qsizetype bytes)
+{
+    frameMemoryBudget = bytes;
+    evictFrames();
+}
+
+qsizetype SpriteModel::getFrameMemoryBudget() const
+{
+    return frameMemoryBudget;
+}
+
+void SpriteModel::evictFrames()
+{
+    qsizetype used = getMemoryUsage();
+    if (used <= frameMemoryBudget)
+    {
+        return;
+    }
+
+    // the frames edited longest ago go first, the edited frame and its neighbours stay for quick switching
+    const int current = int(frames.indexOf(editingFrame));
+    QVector<Sprite *> candidates;
+    for (int i = 0; i < frames.size(); ++i)
+    {
+        if (frames[i]->isLoaded() && (current < 0 || qAbs(i - current) > 1))
+        {
+            candidates.append(frames[i]);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](const Sprite *a, const Sprite *b) {
+        return lastFocused.value(a) < lastFocused.value(b);
+    });
+
+    for (Sprite *frame : std::as_const(candidates))
+    {
+        if (used <= frameMemoryBudget)
+        {
+            break;
+        }
+
+        // counted again in full, as unloading a frame that shares its pixels frees nothing
+        if (frame->unload())
+        {
+            used = getMemoryUsage();
+        }
+    }
+}
+
+QString SpriteModel::getFileName() const
+{
+    return fileName;
+}
+
+QVector<int> SpriteModel::findIdenticalFrames() const
+{
+    QVector<int> identical(frames.size());
+    QMultiHash<size_t, int> loadedByHash;
+    QHash<QPair<const FrameStore *, int>, int> storedByRecord;
+
+    for (int i = 0; i < frames.size(); ++i)
+    {
+        const Sprite *frame = frames[i];
+        const StoredFrame stored = frame->getStoredFrame();
+        const QPair<const FrameStore *, int> record(stored.store.data(), stored.index);
+        identical[i] = stored.store ? storedByRecord.value(record, i) : i;
+
+        // hashes only narrow down the frames to compare, a match is only taken once every pixel is equal
+        if (identical[i] == i && frame->isLoaded())
+        {
+            const size_t hash = frame->getContentHash();
+            for (int candidate : loadedByHash.values(hash))
+            {
+                if (frame->hasSameContent(*frames[candidate]))
+                {
+                    identical[i] = candidate;
+                    break;
+                }
+            }
+            if (identical[i] == i)
+            {
+                loadedByHash.insert(hash, i);
+            }
+        }
+        if (stored.store && !storedByRecord.contains(record))
+        {
+            storedByRecord.insert(record, identical[i]);
+        }
+    }
+    return identical;
+}
+
+void SpriteModel::shareFrames()
+{
+    const QVector<int> identical = findIdenticalFrames();
+    for (int i = 0; i < frames.size(); ++i)
+    {
+        // frames matched by their record may still be stored differently, one indexed and one not
+        Sprite *source = frames[identical[i]];
+        if (identical[i] != i && frames[i]->hasSameContent(*source))
+        {
+            frames[i]->shareLayers(*source);
+        }
+    }
+}
+
+void SpriteModel::compactFrames()
+{
+    const int oldSize = palette.size();
+    for (int i = 0; i < frames.size(); ++i)
+    {
+        if (frames[i] != editingFrame && !frames[i]->compact(palette))
+        {
+            qWarning() << "Frame" << i << "has more colors than the palette holds and is kept at 32 bits";
+        }
+    }
+
+    if (palette.size() != oldSize)
+    {
+        emit paletteChanged();
+    }
+}
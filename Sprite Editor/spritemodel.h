@@ -1,5 +1,5 @@
 /**
- * Handles spritie project state. Manages frames, clipboard actions, and undo/redo history. Handles save / load from JSON.
+ * Handles spritie project state. Manages frames, clipboard actions, and undo/redo history. Handles save / load of .ssp files.
  *
  * @author John Gibb
  * @date March 31, 2025
@@ -9,12 +9,11 @@
 #ifndef SPRITEMODEL_H
 #define SPRITEMODEL_H
 
-#include <QFile>
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include <QHash>
 #include <QListWidgetItem>
 #include <QObject>
+#include "colorpalette.h"
+#include "projectfile.h"
 #include "sprite.h"
 #include <stack>
 
@@ -34,17 +33,34 @@ public:
     explicit SpriteModel(int defaultSize = 2, QObject *parent = nullptr);
 
     /**
-     * @brief loadProject Loads a given Json into a Sprite.
-     * @param fileName The path where the .ssp project file will be saved.
+     * @brief loadProject Loads a .ssp project into the Sprite. Both the binary format and the
+     * older JSON format are accepted. Binary projects only have their record index read, and
+     * each frame is decoded the first time it is needed, so opening takes the same time however
+     * many frames the project holds. Legacy JSON projects are converted in full. Frames saved as duplicates
+     * of an earlier frame are read from its record.
+     * @param fileName The path of the .ssp project file.
      */
     void loadProject(const QString &fileName);
 
     /**
-     * @brief saveProject Saves the Sprite to a json object.
+     * @brief saveProject Saves the Sprite in the binary .ssp format. Frames are encoded in
+     * parallel on the global thread pool and written in order, emitting saveProgress as they go.
+     * Frames unchanged since they were loaded are copied without being decoded, and frames identical to an
+     * earlier frame are written as references to it.
      * @param fileName THe path of .ssp project file.
      */
     void saveProject(const QString &fileName);
 
+    /**
+     * @brief exportAnimation Exports the frames as a sprite sheet (.png), animated GIF (.gif)
+     * or animated PNG (.apng), chosen by the file extension. Encoding runs off the GUI thread
+     * while events keep being processed.
+     * @param fileName The path to export to.
+     * @param fps The playback speed of animated formats.
+     * @return True if the file was written.
+     */
+    bool exportAnimation(const QString &fileName, int fps);
+
     /**
      * @brief copy Adds the frame at the given position in the sprite frame list to the clipboard. For example, if
      * 3 is given, the fourth frame in the sprite is added to the clipboard.
@@ -82,7 +98,89 @@ public:
      */
     int getFrameCount() const;
 
+    /**
+     * @brief setIndexedMode Turns indexed color mode on or off. While it is on, every frame except the one being
+     * edited stores its layers as 8-bit indices into the project palette, a quarter of the memory, and the palette
+     * is saved with the project.
+     * @param indexed Whether frames are stored as palette indices.
+     */
+    void setIndexedMode(bool indexed);
+
+    /**
+     * @brief isIndexedMode Returns whether frames are stored as palette indices.
+     */
+    bool isIndexedMode() const;
+
+    /**
+     * @brief getMemoryUsage Gets how many bytes of pixels every frame holds together, counting their layers,
+     * composites and undo histories. Pixels shared by identical frames are counted once.
+     */
+    qsizetype getMemoryUsage() const;
+
+    /**
+     * @brief getPalette Gets the colors shared by the frames of the project.
+     */
+    const ColorPalette &getPalette() const;
+
+    /**
+     * @brief setPaletteColor Changes a color of the palette, recoloring every pixel of every frame that uses
+     * it. Frames are recolored by swapping their color tables, so the cost does not depend on their size.
+     * Unloaded frames stay unloaded, and take the new colors when they are next decoded.
+     * @param index The index of the color to change.
+     * @param color The new non-premultiplied ARGB32 color.
+     */
+    void setPaletteColor(int index, QRgb color);
+
+    /**
+     * @brief focusFrame Tells the model which frame is being edited. That frame is loaded, and in indexed
+     * mode it is expanded for drawing and the one edited before it is compacted again. Frames edited longest
+     * ago are then unloaded until the frames fit the memory budget.
+     * @param sprite The frame being edited.
+     */
+    void focusFrame(Sprite *sprite);
+
+    /**
+     * @brief setFrameMemoryBudget Sets how many bytes the frames may hold before those edited longest ago
+     * are unloaded. The edited frame and its neighbours are always kept.
+     * @param bytes The budget in bytes.
+     */
+    void setFrameMemoryBudget(qsizetype bytes);
+
+    /**
+     * @brief getFrameMemoryBudget Gets how many bytes the frames may hold before some are unloaded.
+     */
+    qsizetype getFrameMemoryBudget() const;
+
+    /**
+     * @brief findIdenticalFrames Finds the frames that repeat an earlier frame, such as the held frames of an
+     * animation. Loaded frames are found by content hash and then compared pixel for pixel, unloaded frames
+     * by the record they are stored in, so no frame is decoded to be compared.
+     * @return For each frame, the position of the first frame identical to it, which is itself if it does
+     * not repeat an earlier frame.
+     */
+    QVector<int> findIdenticalFrames() const;
+
+    /**
+     * @brief getFileName Gets the path the project was last loaded from or saved to.
+     * @return The path, or an empty string for a project that was never saved.
+     */
+    QString getFileName() const;
+
+    /**
+     * The memory budget of the frames unless another is set, in bytes.
+     */
+    static const qsizetype DefaultFrameMemoryBudget = qsizetype(512) * 1024 * 1024;
+
 private:
+    // Unloads the frames edited longest ago until the frames fit the memory budget.
+    void evictFrames();
+
+    // Makes loaded frames identical to an earlier frame share its pixels, until either is drawn on.
+    void shareFrames();
+
+    // Compacts every frame except the one being edited, adding their colors to the palette.
+    void compactFrames();
+
     // The array of all frames in the sprite model.
     QVector<Sprite *> frames;
 
@@ -97,6 +195,27 @@ private:
 
     // The index of the current frame being displayed
     int frameIndex;
+
+    // The colors shared by every frame in indexed mode.
+    ColorPalette palette;
+
+    // Whether frames other than the edited one are stored as palette indices.
+    bool indexedMode = false;
+
+    // The frame being edited, which is never compact.
+    Sprite *editingFrame = nullptr;
+
+    // How many bytes the frames may hold before some are unloaded.
+    qsizetype frameMemoryBudget = DefaultFrameMemoryBudget;
+
+    // When each frame was last edited, counted in calls to focusFrame.
+    QHash<const Sprite *, quint64> lastFocused;
+
+    // The number of calls to focusFrame so far.
+    quint64 focusCount = 0;
+
+    // The path the project was last loaded from or saved to, empty if it never was.
+    QString fileName;
 signals:
     // Adds the sprite to the frameMenu
     void updateFrameMenu();
@@ -112,6 +231,15 @@ signals:
 
     // Toggle method which toggles the delete button on or off.
     void disableDeleteButton(bool disable);
+
+    // Reports how many frames of a project have been decoded while loading.
+    void loadProgress(int framesDone, int frameCount);
+
+    // Reports how many frames of a project have been written while saving.
+    void saveProgress(int framesDone, int frameCount);
+
+    // Reports that colors of the palette were added or changed.
+    void paletteChanged();
 };
 
 #endif // SPRITEMODEL_H
@@ -45,6 +45,9 @@ void StartMenu::on_projectLoad_clicked()
     if (!fileName.isEmpty())
     {
         SpriteModel *model = new SpriteModel(2, this);
+        connect(model, &SpriteModel::loadProgress, this, [this](int framesDone, int frameCount) {
+            setWindowTitle("Loading frame " + QString::number(framesDone) + " of " + QString::number(frameCount));
+        });
         model->loadProject(fileName);
 
         SpriteEditor *editor = new SpriteEditor(model);
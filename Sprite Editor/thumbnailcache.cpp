@@ -0,0 +1,143 @@
+/**
+ * Implementation of the ThumbnailCache class, which keeps the frame menu icons up to date.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Cheuk Yin Lau
+ */
+
+#include "thumbnailcache.h"
+#include "compositor.h"
+#include "diagnostics.h"
+
+#include <QSet>
+#include <QtConcurrent>
+
+ThumbnailCache::ThumbnailCache(SpriteModel *model, QSize iconSize, QObject *parent)
+    : QObject(parent)
+    , model(model)
+    , iconSize(iconSize)
+{
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::CoarseTimer);
+    timer.setInterval(100);
+
+    connect(&timer,
+            &QTimer::timeout,
+            this,
+            &ThumbnailCache::regenerate);
+    connect(&watcher,
+            &QFutureWatcherBase::finished,
+            this,
+            &ThumbnailCache::applyResults);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    watcher.waitForFinished();
+}
+
+void ThumbnailCache::scheduleUpdate()
+{
+    if (!timer.isActive())
+    {
+        timer.start();
+    }
+}
+
+void ThumbnailCache::regenerate()
+{
+    if (watcher.isRunning())
+    {
+        rerunRequested = true;  // Picked up again once the running pass finishes
+        return;
+    }
+
+    const int frameCount = model->getFrameCount();
+    shownAt.resize(frameCount);
+
+    QVector<Thumbnail> jobs;
+    QSet<const Sprite *> live;
+    for (int i = 0; i < frameCount; i++)
+    {
+        const Sprite *sprite = model->getFrame(i);
+        live.insert(sprite);
+
+        // Reuse the icon if the frame has not changed, it may only have moved in the menu
+        auto cached = icons.constFind(sprite);
+        if (cached != icons.constEnd() && cached->version == sprite->getVersion())
+        {
+            if (shownAt[i] != sprite)
+            {
+                shownAt[i] = sprite;
+                emit thumbnailReady(i, cached->image);
+            }
+            continue;
+        }
+
+        // Unloaded frames are decoded on the worker, without loading them
+        if (sprite->isLoaded())
+        {
+            jobs.append({i, sprite, sprite->getVersion(), sprite->getImage(), StoredFrame()});
+        }
+        else
+        {
+            jobs.append({i, sprite, sprite->getVersion(), QImage(), sprite->getStoredFrame()});
+        }
+    }
+
+    // Forget the icons of deleted frames
+    for (auto it = icons.begin(); it != icons.end();)
+    {
+        it = live.contains(it.key()) ? std::next(it) : icons.erase(it);
+    }
+
+    if (jobs.isEmpty())
+    {
+        return;
+    }
+
+    // Only shallow image copies, stored records and plain values cross to the worker
+    const QSize size = iconSize;
+    passStart = Diagnostics::now();
+    watcher.setFuture(QtConcurrent::run([jobs, size]() {
+        QVector<Thumbnail> results = jobs;
+        for (Thumbnail &thumbnail : results)
+        {
+            Diagnostics::Scope scope("thumbnail", "frames");
+            if (thumbnail.image.isNull())
+            {
+                thumbnail.image = Compositor::flattened(thumbnail.stored.decode());
+                thumbnail.stored = StoredFrame();
+            }
+            thumbnail.image = thumbnail.image.scaled(size, Qt::KeepAspectRatio, Qt::FastTransformation);
+        }
+        return results;
+    }));
+}
+
+void ThumbnailCache::applyResults()
+{
+    const QVector<Thumbnail> results = watcher.result();
+    Diagnostics::recordSince("thumbnails", "frames", passStart);  // From scheduling the pass to its icons arriving
+    for (const Thumbnail &thumbnail : results)
+    {
+        // The frame may have been edited, moved or deleted while it was being scaled
+        if (model->getFrame(thumbnail.index) != thumbnail.sprite
+            || thumbnail.sprite->getVersion() != thumbnail.version)
+        {
+            rerunRequested = true;
+            continue;
+        }
+
+        icons.insert(thumbnail.sprite, thumbnail);
+        shownAt[thumbnail.index] = thumbnail.sprite;
+        emit thumbnailReady(thumbnail.index, thumbnail.image);
+    }
+
+    if (rerunRequested)
+    {
+        rerunRequested = false;
+        scheduleUpdate();
+    }
+}
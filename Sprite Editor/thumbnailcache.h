@@ -0,0 +1,108 @@
+/**
+ * Declaration of the ThumbnailCache class, which keeps the frame menu icons up to date.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Cheuk Yin Lau
+ */
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QTimer>
+#include <QVector>
+#include "spritemodel.h"
+
+/**
+ * The ThumbnailCache class produces the scaled icons shown in the frame menu. It remembers
+ * which version of each frame its icon was made from, so only frames that changed are
+ * rescaled. Requests are coalesced on a coarse timer and the scaling itself runs on the
+ * global thread pool, with the finished icons handed back on the GUI thread.
+ */
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * @brief Constructs a cache for the frames of a model.
+     * @param model The model whose frames are shown as icons.
+     * @param iconSize The size the icons are scaled to fit.
+     * @param parent Optional QObject parent.
+     */
+    ThumbnailCache(SpriteModel *model, QSize iconSize, QObject *parent = nullptr);
+
+    /**
+     * @brief Waits for any icons still being scaled before the cache goes away.
+     */
+    ~ThumbnailCache();
+
+public slots:
+
+    /**
+     * @brief Requests that stale icons be regenerated. Requests arriving before the
+     * timer fires are merged into a single pass.
+     */
+    void scheduleUpdate();
+
+signals:
+
+    /**
+     * @brief Signals that the icon of a frame menu entry should change.
+     * @param frameIndex The position of the frame in the model.
+     * @param icon The scaled image of the frame.
+     */
+    void thumbnailReady(int frameIndex, const QImage &icon);
+
+private slots:
+
+    // Finds the frames whose icons are stale and starts scaling them.
+    void regenerate();
+
+    // Publishes the icons produced by the last pass.
+    void applyResults();
+
+private:
+
+    // A frame to scale, or a scaled icon, along with the frame version it was made from.
+    struct Thumbnail
+    {
+        int index;
+        const Sprite *sprite;
+        quint64 version;
+        QImage image;           // Null for an unloaded frame until the worker decodes it
+        StoredFrame stored;     // The pixels of an unloaded frame
+    };
+
+    // The model whose frames are shown as icons.
+    SpriteModel *model;
+
+    // The size the icons are scaled to fit.
+    QSize iconSize;
+
+    // Coalesces update requests.
+    QTimer timer;
+
+    // Watches the scaling pass running on the thread pool.
+    QFutureWatcher<QVector<Thumbnail>> watcher;
+
+    // The newest icon made for each frame.
+    QHash<const Sprite *, Thumbnail> icons;
+
+    // The frame whose icon is currently shown at each menu position.
+    QVector<const Sprite *> shownAt;
+
+    // When the running pass started, for the diagnostics overlay.
+    qint64 passStart = 0;
+
+    // Set when an update is requested while a pass is still running.
+    bool rerunRequested = false;
+};
+
+#endif // THUMBNAILCACHE_H
@@ -0,0 +1,191 @@
+/**
+ * Implementation of the TileSet class, which tracks regions of an image in 64x64 pixel tiles.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Cheuk Yin Lau
+ */
+
+#include "tileset.h"
+#include "pixelops.h"
+
+#include <algorithm>
+
+TileSet::TileSet(const QSize &imageSize)
+    : imageSize(imageSize)
+{
+    if (imageSize.isValid())
+    {
+        tileColumns = (imageSize.width() + TileSize - 1) / TileSize;
+        tileRows = (imageSize.height() + TileSize - 1) / TileSize;
+        bits.resize(tileColumns * tileRows);
+    }
+}
+
+TileSet TileSet::fromImage(const QImage &image)
+{
+    TileSet set(image.size());
+    for (int row = 0; row < set.tileRows; ++row)
+    {
+        for (int column = 0; column < set.tileColumns; ++column)
+        {
+            const QRect tile = set.tileRect(column, row);
+            bool used = false;
+            for (int y = tile.top(); y <= tile.bottom() && !used; ++y)
+            {
+                const QRgb *line = PixelOps::constRow(image, y);
+                used = std::any_of(line + tile.left(), line + tile.right() + 1, [](QRgb pixel) {
+                    return pixel != 0;
+                });
+            }
+            if (used)
+            {
+                set.insertTile(column, row);
+            }
+        }
+    }
+    return set;
+}
+
+bool TileSet::isNull() const
+{
+    return !imageSize.isValid();
+}
+
+bool TileSet::isEmpty() const
+{
+    return !isNull() && setCount == 0;
+}
+
+int TileSet::count() const
+{
+    return setCount;
+}
+
+int TileSet::tileCount() const
+{
+    return tileColumns * tileRows;
+}
+
+int TileSet::columns() const
+{
+    return tileColumns;
+}
+
+int TileSet::rows() const
+{
+    return tileRows;
+}
+
+void TileSet::insert(const QRect &pixels)
+{
+    const QRect clipped = pixels.intersected(QRect(QPoint(0, 0), imageSize));
+    if (clipped.isEmpty())
+    {
+        return;
+    }
+
+    for (int row = clipped.top() / TileSize; row <= clipped.bottom() / TileSize; ++row)
+    {
+        for (int column = clipped.left() / TileSize; column <= clipped.right() / TileSize; ++column)
+        {
+            insertTile(column, row);
+        }
+    }
+}
+
+void TileSet::insertTile(int column, int row)
+{
+    const int index = indexOf(column, row);
+    if (!bits.testBit(index))
+    {
+        bits.setBit(index);
+        setCount++;
+    }
+}
+
+void TileSet::clear()
+{
+    bits.fill(false);
+    setCount = 0;
+}
+
+bool TileSet::containsTile(int column, int row) const
+{
+    return isNull() || bits.testBit(indexOf(column, row));
+}
+
+bool TileSet::intersects(const QRect &pixels) const
+{
+    if (isNull())
+    {
+        return true;
+    }
+
+    const QRect clipped = pixels.intersected(QRect(QPoint(0, 0), imageSize));
+    if (clipped.isEmpty() || setCount == 0)
+    {
+        return false;
+    }
+
+    for (int row = clipped.top() / TileSize; row <= clipped.bottom() / TileSize; ++row)
+    {
+        for (int column = clipped.left() / TileSize; column <= clipped.right() / TileSize; ++column)
+        {
+            if (bits.testBit(indexOf(column, row)))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+QRect TileSet::tileRect(int column, int row) const
+{
+    return QRect(column * TileSize, row * TileSize, TileSize, TileSize)
+        .intersected(QRect(QPoint(0, 0), imageSize));
+}
+
+QVector<QRect> TileSet::rects(const QRect &clip) const
+{
+    if (isNull())
+    {
+        return clip.isEmpty() ? QVector<QRect>() : QVector<QRect>{clip};
+    }
+
+    QVector<QRect> result;
+    const QRect clipped = clip.intersected(QRect(QPoint(0, 0), imageSize));
+    if (clipped.isEmpty() || setCount == 0)
+    {
+        return result;
+    }
+
+    const int lastColumn = clipped.right() / TileSize;
+    for (int row = clipped.top() / TileSize; row <= clipped.bottom() / TileSize; ++row)
+    {
+        int column = clipped.left() / TileSize;
+        while (column <= lastColumn)
+        {
+            if (!bits.testBit(indexOf(column, row)))
+            {
+                column++;
+                continue;
+            }
+
+            // Extend the run over neighbouring tiles of the same row
+            const int first = column;
+            while (column <= lastColumn && bits.testBit(indexOf(column, row)))
+            {
+                column++;
+            }
+            result.append((tileRect(first, row) | tileRect(column - 1, row)).intersected(clipped));
+        }
+    }
+    return result;
+}
+
+int TileSet::indexOf(int column, int row) const
+{
+    return row * tileColumns + column;
+}
@@ -0,0 +1,144 @@
+/**
+ * Declaration of the TileSet class, which tracks regions of an image in 64x64 pixel tiles.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Cheuk Yin Lau
+ */
+
+#ifndef TILESET_H
+#define TILESET_H
+
+#include <QBitArray>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+/**
+ * The TileSet class divides an image into square tiles and remembers which of them are in
+ * the set. Layers use it to know which tiles have ever been painted, so empty regions can
+ * be skipped when compositing and saving, and strokes use it to capture undo data for only
+ * the tiles they touch. A null set, made without an image size, stands for "every tile".
+ */
+class TileSet
+{
+public:
+
+    /**
+     * The side length of a tile in pixels.
+     */
+    static const int TileSize = 64;
+
+    /**
+     * @brief Constructs an empty set of tiles covering an image.
+     * @param imageSize The size of the image, or an invalid size for a null set.
+     */
+    explicit TileSet(const QSize &imageSize = QSize());
+
+    /**
+     * @brief Builds the set of tiles of an image that hold any pixel other than 0,
+     * fully transparent in premultiplied ARGB.
+     * @param image The 32-bit image to scan.
+     * @return The tiles with visible content.
+     */
+    static TileSet fromImage(const QImage &image);
+
+    /**
+     * @brief Returns whether the set was made without an image size and so covers everything.
+     */
+    bool isNull() const;
+
+    /**
+     * @brief Returns whether no tile is in the set. A null set is never empty.
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Gets the number of tiles in the set.
+     */
+    int count() const;
+
+    /**
+     * @brief Gets the number of tiles covering the image.
+     */
+    int tileCount() const;
+
+    /**
+     * @brief Gets the number of tile columns.
+     */
+    int columns() const;
+
+    /**
+     * @brief Gets the number of tile rows.
+     */
+    int rows() const;
+
+    /**
+     * @brief Adds every tile overlapping a rectangle of pixels.
+     * @param pixels The rectangle, clipped to the image.
+     */
+    void insert(const QRect &pixels);
+
+    /**
+     * @brief Adds a single tile.
+     * @param column The column of the tile.
+     * @param row The row of the tile.
+     */
+    void insertTile(int column, int row);
+
+    /**
+     * @brief Removes every tile from the set.
+     */
+    void clear();
+
+    /**
+     * @brief Returns whether a tile is in the set.
+     * @param column The column of the tile.
+     * @param row The row of the tile.
+     */
+    bool containsTile(int column, int row) const;
+
+    /**
+     * @brief Returns whether any tile overlapping a rectangle of pixels is in the set.
+     * @param pixels The rectangle to test.
+     */
+    bool intersects(const QRect &pixels) const;
+
+    /**
+     * @brief Gets the pixels covered by a tile, clipped to the image.
+     * @param column The column of the tile.
+     * @param row The row of the tile.
+     */
+    QRect tileRect(int column, int row) const;
+
+    /**
+     * @brief Gets the pixels covered by the set as rectangles, with neighbouring tiles of a
+     * row merged into a single rectangle.
+     * @param clip Only the part of each rectangle inside clip is returned.
+     * @return The covered rectangles, top to bottom. A null set returns clip itself.
+     */
+    QVector<QRect> rects(const QRect &clip) const;
+
+private:
+
+    // Converts a tile position to its bit.
+    int indexOf(int column, int row) const;
+
+    // The size of the image the tiles cover.
+    QSize imageSize;
+
+    // The number of tile columns.
+    int tileColumns = 0;
+
+    // The number of tile rows.
+    int tileRows = 0;
+
+    // One bit per tile, row by row.
+    QBitArray bits;
+
+    // The number of set bits.
+    int setCount = 0;
+};
+
+#endif // TILESET_H
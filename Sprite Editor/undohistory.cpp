@@ -0,0 +1,319 @@
+/**
+ * Implementation of the UndoHistory class, which records paint strokes as deltas.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Matthew Shaw
+ */
+
+#include "undohistory.h"
+
+#include <QDebug>
+#include <cstring>
+
+UndoHistory::UndoHistory(qsizetype memoryBudget)
+    : memoryBudget(memoryBudget)
+{
+
+}
+
+void UndoHistory::setMemoryBudget(qsizetype bytes)
+{
+    memoryBudget = bytes;
+    enforceBudget();
+}
+
+qsizetype UndoHistory::getMemoryBudget() const
+{
+    return memoryBudget;
+}
+
+qsizetype UndoHistory::getMemoryUsage() const
+{
+    return memoryUsage;
+}
+
+void UndoHistory::setCompressionEnabled(bool enabled)
+{
+    compressionEnabled = enabled;
+}
+
+void UndoHistory::beginStroke(const QImage &image)
+{
+    strokeOrigin = image;   // Shallow copy, the canvas detaches on its first write
+    strokeTiles = TileSet();
+    strokePatches.clear();
+}
+
+void UndoHistory::beginTiledStroke(const QSize &imageSize)
+{
+    strokeOrigin = QImage();
+    strokeTiles = TileSet(imageSize);
+    strokePatches.clear();
+}
+
+void UndoHistory::captureTiles(const QImage &image, const TileSet &tiles)
+{
+    if (strokeTiles.isNull())
+    {
+        return;
+    }
+
+    for (int row = 0; row < tiles.rows(); ++row)
+    {
+        for (int column = 0; column < tiles.columns(); ++column)
+        {
+            if (tiles.containsTile(column, row))
+            {
+                captureTile(image, column, row);
+            }
+        }
+    }
+}
+
+void UndoHistory::captureTiles(const QImage &image, const QRect &pixels)
+{
+    const QRect clipped = pixels.intersected(image.rect());
+    if (strokeTiles.isNull() || clipped.isEmpty())
+    {
+        return;
+    }
+
+    for (int row = clipped.top() / TileSet::TileSize; row <= clipped.bottom() / TileSet::TileSize; ++row)
+    {
+        for (int column = clipped.left() / TileSet::TileSize; column <= clipped.right() / TileSet::TileSize; ++column)
+        {
+            captureTile(image, column, row);
+        }
+    }
+}
+
+void UndoHistory::captureTile(const QImage &image, int column, int row)
+{
+    if (strokeTiles.containsTile(column, row))
+    {
+        return;
+    }
+
+    strokeTiles.insertTile(column, row);
+    Patch patch;
+    patch.rect = strokeTiles.tileRect(column, row);
+    patch.before = capture(image, patch.rect, false);
+    strokePatches.append(std::move(patch));
+}
+
+void UndoHistory::endStroke(const QImage &image, const QRect &dirtyRect, int target)
+{
+    QRect rect = dirtyRect.intersected(image.rect());
+
+    Delta delta;
+    delta.target = target;
+    delta.compressed = compressionEnabled;
+
+    if (!strokeOrigin.isNull() && !rect.isEmpty())
+    {
+        Patch patch;
+        patch.rect = rect;
+        patch.before = capture(strokeOrigin, rect, compressionEnabled);
+        patch.after = capture(image, rect, compressionEnabled);
+        delta.patches.append(std::move(patch));
+    }
+
+    for (Patch &patch : strokePatches)
+    {
+        // Tiles are saved before the brush is applied, so some may not have changed at all
+        patch.after = capture(image, patch.rect, false);
+        if (!patch.rect.intersects(rect) || patch.after == patch.before)
+        {
+            continue;
+        }
+
+        if (compressionEnabled)
+        {
+            patch.before = qCompress(patch.before, 1);
+            patch.after = qCompress(patch.after, 1);
+        }
+        delta.patches.append(std::move(patch));
+    }
+
+    strokeOrigin = QImage();    // Releases the pre-stroke pixels
+    strokeTiles = TileSet();
+    strokePatches.clear();
+
+    if (!delta.patches.isEmpty())
+    {
+        push(std::move(delta));
+    }
+}
+
+bool UndoHistory::canUndo() const
+{
+    return !undoEntries.empty();
+}
+
+bool UndoHistory::canRedo() const
+{
+    return !redoEntries.isEmpty();
+}
+
+int UndoHistory::undoTarget() const
+{
+    return undoEntries.empty() ? -1 : undoEntries.back().target;
+}
+
+int UndoHistory::redoTarget() const
+{
+    return redoEntries.isEmpty() ? -1 : redoEntries.top().target;
+}
+
+QVector<QRect> UndoHistory::undo(QImage &image)
+{
+    if (undoEntries.empty())
+    {
+        return {};
+    }
+
+    Delta delta = std::move(undoEntries.back());
+    undoEntries.pop_back();
+    QVector<QRect> changed = apply(image, delta, false);
+    redoEntries.push(std::move(delta));
+    return changed;
+}
+
+QVector<QRect> UndoHistory::redo(QImage &image)
+{
+    if (redoEntries.isEmpty())
+    {
+        return {};
+    }
+
+    Delta delta = redoEntries.pop();
+    QVector<QRect> changed = apply(image, delta, true);
+    undoEntries.push_back(std::move(delta));
+    return changed;
+}
+
+void UndoHistory::clear()
+{
+    undoEntries.clear();
+    redoEntries.clear();
+    strokeOrigin = QImage();
+    strokeTiles = TileSet();
+    strokePatches.clear();
+    memoryUsage = 0;
+}
+
+void UndoHistory::recolor(const QHash<QRgb, QRgb> &colors)
+{
+    if (colors.isEmpty())
+    {
+        return;
+    }
+
+    // Compressed entries may change size once recolored, so the usage is counted again
+    memoryUsage = 0;
+    auto recolorDelta = [&](Delta &delta) {
+        for (Patch &patch : delta.patches)
+        {
+            recolor(patch.before, delta.compressed, colors);
+            recolor(patch.after, delta.compressed, colors);
+        }
+        memoryUsage += delta.bytes();
+    };
+    for (Delta &delta : undoEntries)
+    {
+        recolorDelta(delta);
+    }
+    for (Delta &delta : redoEntries)
+    {
+        recolorDelta(delta);
+    }
+    enforceBudget();
+}
+
+void UndoHistory::recolor(QByteArray &data, bool compressed, const QHash<QRgb, QRgb> &colors)
+{
+    QByteArray pixels = compressed ? qUncompress(data) : data;
+    QRgb *pixel = reinterpret_cast<QRgb *>(pixels.data());
+    for (qsizetype i = 0; i < pixels.size() / 4; ++i)
+    {
+        pixel[i] = colors.value(pixel[i], pixel[i]);
+    }
+    data = compressed ? qCompress(pixels, 1) : pixels;
+}
+
+QByteArray UndoHistory::capture(const QImage &image, const QRect &rect, bool compress)
+{
+    const qsizetype rowBytes = qsizetype(rect.width()) * 4;
+    QByteArray data(rowBytes * rect.height(), Qt::Uninitialized);
+
+    char *out = data.data();
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+    {
+        const uchar *row = image.constScanLine(y) + qsizetype(rect.left()) * 4;
+        std::memcpy(out, row, rowBytes);
+        out += rowBytes;
+    }
+
+    return compress ? qCompress(data, 1) : data;
+}
+
+void UndoHistory::restore(QImage &image, const QRect &rect, const QByteArray &data, bool compressed)
+{
+    const QByteArray pixels = compressed ? qUncompress(data) : data;
+    const qsizetype rowBytes = qsizetype(rect.width()) * 4;
+    if (pixels.size() < rowBytes * rect.height())
+    {
+        qWarning() << "Corrupt undo entry, skipping restore";
+        return;
+    }
+
+    const char *in = pixels.constData();
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+    {
+        uchar *row = image.scanLine(y) + qsizetype(rect.left()) * 4;
+        std::memcpy(row, in, rowBytes);
+        in += rowBytes;
+    }
+}
+
+QVector<QRect> UndoHistory::apply(QImage &image, const Delta &delta, bool after)
+{
+    QVector<QRect> changed;
+    changed.reserve(delta.patches.size());
+    for (const Patch &patch : delta.patches)
+    {
+        restore(image, patch.rect, after ? patch.after : patch.before, delta.compressed);
+        changed.append(patch.rect);
+    }
+    return changed;
+}
+
+void UndoHistory::push(Delta &&delta)
+{
+    for (const Delta &undone : redoEntries)
+    {
+        memoryUsage -= undone.bytes();
+    }
+    redoEntries.clear();
+
+    memoryUsage += delta.bytes();
+    undoEntries.push_back(std::move(delta));
+    enforceBudget();
+}
+
+void UndoHistory::enforceBudget()
+{
+    // Always keep the newest entry so the latest stroke can be undone
+    while (memoryUsage > memoryBudget && undoEntries.size() > 1)
+    {
+        memoryUsage -= undoEntries.front().bytes();
+        undoEntries.pop_front();
+    }
+
+    while (memoryUsage > memoryBudget && !redoEntries.isEmpty())
+    {
+        memoryUsage -= redoEntries.first().bytes();
+        redoEntries.removeFirst();
+    }
+}
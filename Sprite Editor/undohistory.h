@@ -0,0 +1,226 @@
+/**
+ * Declaration of the UndoHistory class, which records paint strokes as deltas.
+ *
+ * @author Hudson Dalby
+ * @date October 19, 2026
+ * @reviewer Matthew Shaw
+ */
+
+#ifndef UNDOHISTORY_H
+#define UNDOHISTORY_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QStack>
+#include <QVector>
+#include <deque>
+#include "tileset.h"
+
+/**
+ * The UndoHistory class stores the undo/redo history of a single image. Instead of
+ * keeping a full copy of the image for every stroke, each entry holds only the patches
+ * of the image changed by that stroke along with their pixels before and after it.
+ * A stroke is either recorded from a snapshot of the whole image, or tile by tile, with
+ * each 64x64 tile saved just before the stroke first writes to it; the latter never copies
+ * more of a large canvas than the stroke actually touches. Entries can optionally be
+ * compressed, and the oldest entries are evicted once the history grows past its memory budget.
+ */
+class UndoHistory
+{
+public:
+
+    /**
+     * @brief Constructs an empty history.
+     * @param memoryBudget The maximum number of bytes the history may hold.
+     */
+    explicit UndoHistory(qsizetype memoryBudget = 64 * 1024 * 1024);
+
+    /**
+     * @brief Sets the memory budget, evicting the oldest entries if it is exceeded.
+     * @param bytes The maximum number of bytes the history may hold.
+     */
+    void setMemoryBudget(qsizetype bytes);
+
+    /**
+     * @brief Gets the memory budget of the history.
+     * @return The maximum number of bytes the history may hold.
+     */
+    qsizetype getMemoryBudget() const;
+
+    /**
+     * @brief Gets the number of bytes currently held by the history.
+     * @return The combined size of every undo and redo entry.
+     */
+    qsizetype getMemoryUsage() const;
+
+    /**
+     * @brief Enables or disables compression of newly recorded entries.
+     * @param enabled True to compress entries, false to store raw pixels.
+     */
+    void setCompressionEnabled(bool enabled);
+
+    /**
+     * @brief Marks the start of a stroke. The image is held as a shallow (implicitly
+     * shared) reference, so the pixels before the stroke stay available once it detaches.
+     * @param image The image as it is before the stroke.
+     */
+    void beginStroke(const QImage &image);
+
+    /**
+     * @brief Marks the start of a stroke recorded tile by tile. captureTiles must be called
+     * before every write the stroke makes.
+     * @param imageSize The size of the image the stroke is made on.
+     */
+    void beginTiledStroke(const QSize &imageSize);
+
+    /**
+     * @brief Saves the tiles a tiled stroke is about to write, unless they were already saved
+     * earlier in the same stroke.
+     * @param image The image before the write.
+     * @param tiles The tiles about to change.
+     */
+    void captureTiles(const QImage &image, const TileSet &tiles);
+
+    /**
+     * @brief Saves the tiles covering a rectangle a tiled stroke is about to write, unless they
+     * were already saved earlier in the same stroke. Only the tiles overlapping the rectangle are
+     * looked at, so it is cheap to call for every span a fill writes.
+     * @param image The image before the write.
+     * @param pixels The pixels about to change.
+     */
+    void captureTiles(const QImage &image, const QRect &pixels);
+
+    /**
+     * @brief Marks the end of a stroke and records its delta. Does nothing if no
+     * stroke was started or nothing inside the dirty rectangle changed.
+     * @param image The image as it is after the stroke.
+     * @param dirtyRect The rectangle of pixels changed by the stroke.
+     * @param target Identifies which image the stroke was made on, for owners of several images.
+     */
+    void endStroke(const QImage &image, const QRect &dirtyRect, int target = 0);
+
+    /**
+     * @brief Returns whether there is an entry to undo.
+     */
+    bool canUndo() const;
+
+    /**
+     * @brief Returns whether there is an entry to redo.
+     */
+    bool canRedo() const;
+
+    /**
+     * @brief Gets the target of the entry that undo would revert.
+     * @return The target passed to endStroke, or -1 if there is nothing to undo.
+     */
+    int undoTarget() const;
+
+    /**
+     * @brief Gets the target of the entry that redo would reapply.
+     * @return The target passed to endStroke, or -1 if there is nothing to redo.
+     */
+    int redoTarget() const;
+
+    /**
+     * @brief Reverts the most recent entry on the given image.
+     * @param image The image to revert.
+     * @return The rectangles of pixels that changed, empty if nothing was undone.
+     */
+    QVector<QRect> undo(QImage &image);
+
+    /**
+     * @brief Reapplies the most recently undone entry on the given image.
+     * @param image The image to update.
+     * @return The rectangles of pixels that changed, empty if nothing was redone.
+     */
+    QVector<QRect> redo(QImage &image);
+
+    /**
+     * @brief Removes every entry from the history.
+     */
+    void clear();
+
+    /**
+     * @brief Replaces colors in the pixels of every entry, so undo and redo keep the colors an image
+     * was given after the entries were recorded.
+     * @param colors Premultiplied colors to replace, old color to new.
+     */
+    void recolor(const QHash<QRgb, QRgb> &colors);
+
+private:
+
+    // A rectangle of the image and its pixels before and after a stroke.
+    struct Patch
+    {
+        QRect rect;
+        QByteArray before;
+        QByteArray after;
+    };
+
+    // A single recorded change: every patch of the image the stroke changed.
+    struct Delta
+    {
+        QVector<Patch> patches;
+        int target = 0;
+        bool compressed = false;
+
+        qsizetype bytes() const
+        {
+            qsizetype total = 0;
+            for (const Patch &patch : patches)
+            {
+                total += patch.before.size() + patch.after.size();
+            }
+            return total;
+        }
+    };
+
+    // Copies the 32-bit pixels of a rectangle into a byte array, compressing if requested.
+    static QByteArray capture(const QImage &image, const QRect &rect, bool compress);
+
+    // Saves a tile for the current tiled stroke, unless it is already saved.
+    void captureTile(const QImage &image, int column, int row);
+
+    // Writes pixels captured by capture() back into a rectangle of the image.
+    static void restore(QImage &image, const QRect &rect, const QByteArray &data, bool compressed);
+
+    // Replaces colors in pixels captured by capture().
+    static void recolor(QByteArray &data, bool compressed, const QHash<QRgb, QRgb> &colors);
+
+    // Writes the before or after pixels of every patch of an entry back into the image.
+    static QVector<QRect> apply(QImage &image, const Delta &delta, bool after);
+
+    // Pushes a new entry, clearing the redo history and evicting old entries if needed.
+    void push(Delta &&delta);
+
+    // Evicts the oldest entries until the history fits within its budget.
+    void enforceBudget();
+
+    // Entries that can be undone, oldest at the front.
+    std::deque<Delta> undoEntries;
+
+    // Entries that can be redone, most recently undone on top.
+    QStack<Delta> redoEntries;
+
+    // The image as it was at the start of the current stroke, null for tiled strokes.
+    QImage strokeOrigin;
+
+    // The tiles saved so far by the current tiled stroke.
+    TileSet strokeTiles;
+
+    // The uncompressed pixels of each saved tile from before the current tiled stroke.
+    QVector<Patch> strokePatches;
+
+    // The maximum number of bytes the history may hold.
+    qsizetype memoryBudget;
+
+    // The number of bytes currently held by the history.
+    qsizetype memoryUsage = 0;
+
+    // Whether newly recorded entries are compressed.
+    bool compressionEnabled = false;
+};
+
+#endif // UNDOHISTORY_H